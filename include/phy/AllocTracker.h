@@ -0,0 +1,429 @@
+/**
+ * Heap allocation tracking for tests and benchmarks. PHY_INSTALL_ALLOCATION_HOOKS()
+ * replaces the global operator new and delete of a program with versions
+ * that count every allocation, per thread and for the whole process; it
+ * expands to nothing unless PHY_TRACK_ALLOCATIONS is defined
+ * (cmake -DPHY_ALLOC_TRACKER=ON).
+ *
+ * An AllocationScope reports what the calling thread, or every thread when
+ * the work is spread over a JobSystem, allocated while it was open. A
+ * capturing scope also records the call stack of each allocation, sites
+ * with the same stack are merged, so a step or a flush that is meant to be
+ * allocation free can print where the heap was used. Stacks are captured
+ * with glibc's backtrace(); elsewhere only the counts are available.
+ */
+#ifndef __BYTENOL_PCGA_ALLOC_TRACKER_H__
+#define __BYTENOL_PCGA_ALLOC_TRACKER_H__
+
+#include <new>
+#include <atomic>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <iomanip>
+
+#if defined(__has_include)
+#if __has_include(<execinfo.h>) && __has_include(<cxxabi.h>)
+#include <execinfo.h>
+#include <cxxabi.h>
+#define PHY_ALLOC_BACKTRACE 1
+#endif
+#endif
+
+namespace phy
+{
+    struct AllocationCounts
+    {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t bytes = 0;     // requested by the allocations
+    };
+
+    /// @brief Allocations sharing one call stack
+    struct AllocationSite
+    {
+        static constexpr int maxFrames = 16;
+
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+        int depth = 0;
+        void* frames[maxFrames];
+    };
+
+    /// @brief Threads an AllocationScope counts
+    enum class AllocationThreads
+    {
+        Calling,    // the thread opening the scope
+        All         // every thread of the process, the workers of a JobSystem included
+    };
+
+    /// @brief Stacks captured by the open scopes of every thread, fixed size so recording never allocates
+    struct AllocationSites
+    {
+        static constexpr int maxSites = 32;
+
+        int count = 0;
+        uint64_t dropped = 0;       // allocations with a new stack once every site was taken
+        AllocationSite sites[maxSites];
+    };
+
+    /// @brief What the hooks know about one thread
+    struct AllocationThreadState
+    {
+        AllocationCounts counts;
+        int captureDepth = 0;       // open capturing scopes of the thread watching only it
+        bool inside = false;        // set while a stack is captured, its allocations are not recorded
+    };
+
+    namespace detail
+    {
+        inline thread_local AllocationThreadState allocationState;
+
+        /// @brief AllocationCounts of every thread together
+        struct AllocationTotals
+        {
+            std::atomic<uint64_t> allocations{ 0 };
+            std::atomic<uint64_t> frees{ 0 };
+            std::atomic<uint64_t> bytes{ 0 };
+        };
+
+        inline AllocationTotals allocationTotals;
+        inline std::atomic<int> captureAll{ 0 };        // open capturing scopes watching every thread
+        inline std::atomic<int> captureScopes{ 0 };     // every open capturing scope, the first clears the sites
+        inline std::atomic_flag sitesLock = ATOMIC_FLAG_INIT;
+        inline AllocationSites allocationSites;
+    }
+
+    class AllocTracker
+    {
+        public:
+            /// @return true if the program installed the hooks, false when every count stays 0
+            static bool installed();
+
+            /// @brief Counts of the calling thread since it started
+            static AllocationCounts counts();
+
+            /// @brief Counts of every thread since the program started
+            static AllocationCounts totalCounts();
+
+            /// @brief Used by the hooks, not meant for anything else
+            static void* allocate(size_t size, size_t alignment);
+            static void release(void* p);
+            static bool markInstalled();
+
+        private:
+            static void record(size_t size);
+
+            static inline bool hooks = false;
+    };
+
+    /**
+     * Counts the allocations of the calling thread, or of every thread,
+     * between its construction and stop() or its destruction. Scopes nest;
+     * the sites are those captured since the outermost capturing scope of
+     * the process opened.
+     */
+    class AllocationScope
+    {
+        public:
+            /// @param name Printed by report()
+            /// @param capture Record the call stack of every allocation
+            /// @param threads All when the work runs on other threads too, such as a JobSystem's
+            explicit AllocationScope(const char* name, bool capture = true, AllocationThreads threads = AllocationThreads::Calling);
+            ~AllocationScope();
+
+            AllocationScope(const AllocationScope&) = delete;
+            AllocationScope& operator=(const AllocationScope&) = delete;
+
+            /// @brief Stop counting, later calls do nothing
+            void stop();
+
+            uint64_t allocations() const;
+            uint64_t bytes() const;
+
+            /// @return true if nothing was allocated
+            bool clean() const;
+
+            /// @brief Stop, then print the counts and every captured site, hottest first
+            void report(std::ostream& out);
+
+        private:
+            AllocationCounts current() const;
+
+            const char* name;
+            bool capture;
+            AllocationThreads threads;
+            bool running = true;
+            AllocationCounts start;
+            AllocationCounts end;
+    };
+
+
+    inline bool AllocTracker::installed()
+    {
+        return hooks;
+    }
+
+    inline AllocationCounts AllocTracker::counts()
+    {
+        return detail::allocationState.counts;
+    }
+
+    inline AllocationCounts AllocTracker::totalCounts()
+    {
+        const auto& t = detail::allocationTotals;
+        return { t.allocations.load(std::memory_order_relaxed), t.frees.load(std::memory_order_relaxed),
+            t.bytes.load(std::memory_order_relaxed) };
+    }
+
+    inline bool AllocTracker::markInstalled()
+    {
+        hooks = true;
+        return hooks;
+    }
+
+    inline void* AllocTracker::allocate(size_t size, size_t alignment)
+    {
+        record(size);
+        if(size == 0)
+            size = 1;
+        if(alignment <= alignof(std::max_align_t))
+            return std::malloc(size);
+        // aligned_alloc wants a multiple of the alignment
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+
+    inline void AllocTracker::release(void* p)
+    {
+        if(!p)
+            return;
+        detail::allocationState.counts.frees++;
+        detail::allocationTotals.frees.fetch_add(1, std::memory_order_relaxed);
+        std::free(p);
+    }
+
+    inline void AllocTracker::record(size_t size)
+    {
+        auto& state = detail::allocationState;
+        state.counts.allocations++;
+        state.counts.bytes += size;
+        detail::allocationTotals.allocations.fetch_add(1, std::memory_order_relaxed);
+        detail::allocationTotals.bytes.fetch_add(size, std::memory_order_relaxed);
+
+#ifdef PHY_ALLOC_BACKTRACE
+        if(state.inside || (state.captureDepth == 0 && detail::captureAll.load(std::memory_order_relaxed) == 0))
+            return;
+
+        state.inside = true;
+        void* frames[AllocationSite::maxFrames];
+        int depth = backtrace(frames, AllocationSite::maxFrames);
+        state.inside = false;
+
+        // a spin lock, the holder only compares and copies frames
+        auto& sites = detail::allocationSites;
+        while(detail::sitesLock.test_and_set(std::memory_order_acquire)) {}
+        bool merged = false;
+        for(int i = 0; i < sites.count && !merged; i++)
+        {
+            auto& site = sites.sites[i];
+            if(site.depth == depth && std::memcmp(site.frames, frames, depth * sizeof(void*)) == 0) {
+                site.count++;
+                site.bytes += size;
+                merged = true;
+            }
+        }
+        if(!merged && sites.count == AllocationSites::maxSites)
+            sites.dropped++;
+        else if(!merged) {
+            auto& site = sites.sites[sites.count++];
+            site.count = 1;
+            site.bytes = size;
+            site.depth = depth;
+            std::memcpy(site.frames, frames, depth * sizeof(void*));
+        }
+        detail::sitesLock.clear(std::memory_order_release);
+#endif
+    }
+
+    inline AllocationScope::AllocationScope(const char* name, bool capture, AllocationThreads threads)
+        : name(name), capture(capture), threads(threads)
+    {
+#ifdef PHY_ALLOC_BACKTRACE
+        if(capture) {
+            // the first backtrace() loads the unwinder, which allocates
+            static thread_local bool warm = false;
+            if(!warm) {
+                void* frames[1];
+                backtrace(frames, 1);
+                warm = true;
+            }
+            if(detail::captureScopes.fetch_add(1) == 0) {
+                while(detail::sitesLock.test_and_set(std::memory_order_acquire)) {}
+                detail::allocationSites.count = 0;
+                detail::allocationSites.dropped = 0;
+                detail::sitesLock.clear(std::memory_order_release);
+            }
+            if(threads == AllocationThreads::All)
+                detail::captureAll.fetch_add(1);
+            else
+                detail::allocationState.captureDepth++;
+        }
+#endif
+        start = current();
+    }
+
+    inline AllocationScope::~AllocationScope()
+    {
+        stop();
+    }
+
+    inline void AllocationScope::stop()
+    {
+        if(!running)
+            return;
+        running = false;
+        end = current();
+#ifdef PHY_ALLOC_BACKTRACE
+        if(capture) {
+            if(threads == AllocationThreads::All)
+                detail::captureAll.fetch_sub(1);
+            else
+                detail::allocationState.captureDepth--;
+            detail::captureScopes.fetch_sub(1);
+        }
+#endif
+    }
+
+    inline AllocationCounts AllocationScope::current() const
+    {
+        return threads == AllocationThreads::All ? AllocTracker::totalCounts() : AllocTracker::counts();
+    }
+
+    inline uint64_t AllocationScope::allocations() const
+    {
+        return (running ? current().allocations : end.allocations) - start.allocations;
+    }
+
+    inline uint64_t AllocationScope::bytes() const
+    {
+        return (running ? current().bytes : end.bytes) - start.bytes;
+    }
+
+    inline bool AllocationScope::clean() const
+    {
+        return allocations() == 0;
+    }
+
+    inline void AllocationScope::report(std::ostream& out)
+    {
+        stop();
+        out << name << ": " << allocations() << " allocations, " << bytes() << " bytes, "
+            << end.frees - start.frees << " frees\n";
+
+#ifdef PHY_ALLOC_BACKTRACE
+        if(!capture)
+            return;
+
+        // a copy, printing allocates and other threads may still record
+        AllocationSites sites;
+        while(detail::sitesLock.test_and_set(std::memory_order_acquire)) {}
+        sites.count = detail::allocationSites.count;
+        sites.dropped = detail::allocationSites.dropped;
+        std::copy(detail::allocationSites.sites, detail::allocationSites.sites + sites.count, sites.sites);
+        detail::sitesLock.clear(std::memory_order_release);
+
+        int order[AllocationSites::maxSites];
+        for(int i = 0; i < sites.count; i++)
+            order[i] = i;
+        for(int i = 1; i < sites.count; i++)
+            for(int j = i; j > 0 && sites.sites[order[j]].count > sites.sites[order[j - 1]].count; j--)
+                std::swap(order[j], order[j - 1]);
+
+        for(int k = 0; k < sites.count; k++)
+        {
+            const AllocationSite& site = sites.sites[order[k]];
+            out << "  " << site.count << " allocations, " << site.bytes << " bytes from\n";
+
+            char** symbols = backtrace_symbols(site.frames, site.depth);
+            bool hook = true;
+            for(int f = 0, shown = 0; f < site.depth; f++)
+            {
+                // "binary(mangled+offset) [address]", demangle what is between ( and +
+                const char* text = symbols ? symbols[f] : "?";
+                const char* open = std::strchr(text, '(');
+                const char* plus = open ? std::strchr(open, '+') : nullptr;
+                std::string function;
+                if(open && plus && plus > open + 1) {
+                    std::string mangled(open + 1, plus);
+                    int status = 0;
+                    char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+                    function = status == 0 && demangled ? demangled : mangled;
+                    std::free(demangled);
+                }
+
+                // the stack starts in the hooks, show it from their caller
+                if(hook && (function.empty() || function.find("AllocTracker") != std::string::npos ||
+                    function.find("operator new") != std::string::npos))
+                    continue;
+                hook = false;
+
+                out << "    #" << std::left << std::setw(3) << shown++ << std::right;
+                if(!function.empty())
+                    out << function << "  ";
+                out << text << "\n";
+            }
+            std::free(symbols);
+        }
+        if(sites.dropped)
+            out << "  " << sites.dropped << " allocations from further stacks not recorded\n";
+#endif
+    }
+
+} // namespace phy
+
+
+#ifdef PHY_TRACK_ALLOCATIONS
+
+/// @brief Define the counting global operator new and delete, once in a program
+#define PHY_INSTALL_ALLOCATION_HOOKS() \
+    static const bool phyAllocationHooksInstalled = phy::AllocTracker::markInstalled(); \
+    static void* phyAllocateOrThrow(std::size_t size, std::size_t alignment) \
+    { \
+        void* p = phy::AllocTracker::allocate(size, alignment); \
+        if(!p) throw std::bad_alloc(); \
+        return p; \
+    } \
+    void* operator new(std::size_t size) { return phyAllocateOrThrow(size, 0); } \
+    void* operator new[](std::size_t size) { return phyAllocateOrThrow(size, 0); } \
+    void* operator new(std::size_t size, std::align_val_t a) { return phyAllocateOrThrow(size, (std::size_t)a); } \
+    void* operator new[](std::size_t size, std::align_val_t a) { return phyAllocateOrThrow(size, (std::size_t)a); } \
+    void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return phy::AllocTracker::allocate(size, 0); } \
+    void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return phy::AllocTracker::allocate(size, 0); } \
+    void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return phy::AllocTracker::allocate(size, (std::size_t)a); } \
+    void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return phy::AllocTracker::allocate(size, (std::size_t)a); } \
+    void operator delete(void* p) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete[](void* p) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete(void* p, std::size_t) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete[](void* p, std::size_t) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete(void* p, std::align_val_t) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete[](void* p, std::align_val_t) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete(void* p, std::size_t, std::align_val_t) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete(void* p, const std::nothrow_t&) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete[](void* p, const std::nothrow_t&) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { phy::AllocTracker::release(p); } \
+    void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { phy::AllocTracker::release(p); }
+
+#else
+
+#define PHY_INSTALL_ALLOCATION_HOOKS()
+
+#endif
+
+
+#endif
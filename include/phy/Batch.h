@@ -0,0 +1,281 @@
+/**
+ * CPU side of the batched draw paths of Canvas2d. A batch only collects
+ * per-frame data, so it can be filled and measured without an OpenGL context.
+ *
+ * The commands of the draw paths are written once here against an Api
+ * template parameter: Canvas2d runs them on OpenGL (GLApi of phy.h) and
+ * CountingApi only counts them, so a benchmark counts the very calls the
+ * canvas makes.
+ */
+#ifndef __BYTENOL_PCGA_BATCH_H__
+#define __BYTENOL_PCGA_BATCH_H__
+
+#include <vector>
+#include <cstddef>
+
+namespace phy
+{
+    /// @brief Commands submitted to the graphics api, used to compare draw paths
+    struct DrawCounters
+    {
+        size_t drawCalls = 0;
+        size_t bufferUploads = 0;
+        size_t uniformUploads = 0;
+        size_t bindings = 0;
+        size_t vertices = 0;    // vertex shader invocations, not counted in total()
+
+        size_t total() const { return drawCalls + bufferUploads + uniformUploads + bindings; }
+    };
+
+    /// @brief How Canvas2d turns a batched circle into fragments
+    enum class CircleMode
+    {
+        Mesh,   // triangle fan of circleSegments around the center
+        SDF     // one quad, the edge is antialiased by a signed distance in the fragment shader
+    };
+
+    /// @brief Segments of the circle mesh, also used by Canvas2d::drawArc
+    inline constexpr int circleSegments = 36;
+
+    /// @brief Indexed vertices drawn for every circle in the given mode
+    inline constexpr size_t circleIndexCount(CircleMode mode)
+    {
+        return mode == CircleMode::Mesh ? circleSegments * 3 : 6;
+    }
+
+    /// @brief Pixels rasterized for a circle of radius r (in pixels) in the given mode
+    inline float circleFragmentCount(CircleMode mode, float r)
+    {
+        // the mesh is inscribed in the circle, the quad bounds it with a 1 pixel fringe for antialiasing
+        return mode == CircleMode::Mesh 
+            ? 0.5f * circleSegments * r * r * 0.17364818f    // sin(360 / circleSegments)
+            : 4.0f * (r + 1.0f) * (r + 1.0f);
+    }
+
+    /// @brief Per instance attributes of a circle, laid out for the instance buffer
+    struct CircleInstance
+    {
+        float x;
+        float y;
+        float radius;
+        float r;
+        float g;
+        float b;
+        float a;
+    };
+
+    /// @brief Vertex of a batched line, colored per vertex so color changes do not split the batch
+    struct LineVertex
+    {
+        float x;
+        float y;
+        float r;
+        float g;
+        float b;
+        float a;
+    };
+
+    /// @brief Api of the draw paths that only counts the calls, GLApi of phy.h issues
+    /// them on OpenGL and counts them the same way. Binding object 0 is an unbind
+    /// and is not counted
+    struct CountingApi
+    {
+        DrawCounters counters;
+
+        void useProgram(unsigned int) {}
+        void uniformColor(int, const float*) { counters.uniformUploads++; }
+        void uniformMatrix(int, const float*) { counters.uniformUploads++; }
+        void bindBuffer(unsigned int buffer) { counters.bindings += buffer != 0; }
+        void bindVertexArray(unsigned int vao) { counters.bindings += vao != 0; }
+        void streamBuffer(const void*, size_t, size_t) { counters.bufferUploads++; }
+        void vertexAttrib(unsigned int, float, float, float) {}
+        void drawIndexed(size_t indices, size_t instances) { counters.drawCalls++; counters.vertices += indices * instances; }
+        void drawLines(size_t vertices) { counters.drawCalls++; counters.vertices += vertices; }
+    };
+
+    /// @brief The objects a batch is flushed with, named by the api
+    struct BatchTarget
+    {
+        unsigned int program = 0;
+        int projection = -1;        // uniform location of the projection matrix
+        unsigned int buffer = 0;    // streamed instance or vertex buffer
+        unsigned int vao = 0;
+        size_t indexCount = 0;      // indices drawn per circle instance
+    };
+
+    /// @brief Circles collected over a frame and drawn with a single instanced call
+    class CircleBatch
+    {
+        public:
+            void add(float x, float y, float radius, unsigned int hex, float alpha = 1.0f);
+            void clear();
+
+            bool empty() const;
+            size_t size() const;
+            const CircleInstance* data() const;
+
+        private:
+            std::vector<CircleInstance> instances;
+    };
+
+
+    /// @brief Line segments collected over a frame into a growable client side buffer,
+    /// drawn with a single call when flushed
+    class LineBatch
+    {
+        public:
+            void add(float x1, float y1, float x2, float y2, unsigned int hex, float alpha = 1.0f);
+            void clear();
+
+            bool empty() const;
+            size_t vertexCount() const;
+            const LineVertex* data() const;
+
+        private:
+            std::vector<LineVertex> vertices;
+    };
+
+
+    /// @brief Commands of Canvas2d::setFillColor
+    template<typename Api>
+    void uploadFillColor(Api& api, int location, unsigned int hex, float alpha);
+
+    /// @brief Commands of Canvas2d::drawArc once its matrix is known: the matrix
+    /// and one draw of the circle mesh
+    template<typename Api>
+    void drawMeshCircle(Api& api, int location, const float matrix[16], unsigned int vao, size_t indexCount);
+
+    /// @brief Draw every circle of the batch with one instanced draw call and clear it.
+    /// The instance buffer is orphaned and grown to twice the batch when too small
+    template<typename Api>
+    void flushCircleBatch(Api& api, const BatchTarget& target, const float projection[16],
+        CircleBatch& batch, size_t& capacity);
+
+    /// @brief Draw every segment of the batch with one draw call and clear it, the
+    /// vertex buffer is streamed like the circle instances
+    template<typename Api>
+    void flushLineBatch(Api& api, const BatchTarget& target, const float projection[16],
+        LineBatch& batch, size_t& capacity);
+
+
+    inline void CircleBatch::add(float x, float y, float radius, unsigned int hex, float alpha)
+    {
+        instances.push_back({ x, y, radius,
+            ((hex >> 16) & 0xff) / 255.0f, ((hex >> 8) & 0xff) / 255.0f, (hex & 0xff) / 255.0f, alpha });
+    }
+
+    inline void CircleBatch::clear()
+    {
+        instances.clear();
+    }
+
+    inline bool CircleBatch::empty() const
+    {
+        return instances.empty();
+    }
+
+    inline size_t CircleBatch::size() const
+    {
+        return instances.size();
+    }
+
+    inline const CircleInstance* CircleBatch::data() const
+    {
+        return instances.data();
+    }
+
+    inline void LineBatch::add(float x1, float y1, float x2, float y2, unsigned int hex, float alpha)
+    {
+        const float r = ((hex >> 16) & 0xff) / 255.0f;
+        const float g = ((hex >> 8) & 0xff) / 255.0f;
+        const float b = (hex & 0xff) / 255.0f;
+        vertices.push_back({ x1, y1, r, g, b, alpha });
+        vertices.push_back({ x2, y2, r, g, b, alpha });
+    }
+
+    inline void LineBatch::clear()
+    {
+        vertices.clear();
+    }
+
+    inline bool LineBatch::empty() const
+    {
+        return vertices.empty();
+    }
+
+    inline size_t LineBatch::vertexCount() const
+    {
+        return vertices.size();
+    }
+
+    inline const LineVertex* LineBatch::data() const
+    {
+        return vertices.data();
+    }
+
+    template<typename Api>
+    inline void uploadFillColor(Api& api, int location, unsigned int hex, float alpha)
+    {
+        const float color[4] = { ((hex >> 16) & 0xff) / 255.0f, ((hex >> 8) & 0xff) / 255.0f, (hex & 0xff) / 255.0f, alpha };
+        api.uniformColor(location, color);
+    }
+
+    template<typename Api>
+    inline void drawMeshCircle(Api& api, int location, const float matrix[16], unsigned int vao, size_t indexCount)
+    {
+        api.uniformMatrix(location, matrix);
+        api.bindVertexArray(vao);
+        api.drawIndexed(indexCount, 1);
+    }
+
+    template<typename Api>
+    inline void flushCircleBatch(Api& api, const BatchTarget& target, const float projection[16],
+        CircleBatch& batch, size_t& capacity)
+    {
+        if(batch.empty())
+            return;
+
+        api.useProgram(target.program);
+        api.uniformMatrix(target.projection, projection);
+
+        // orphan the instance buffer so the driver never waits on last frame's draw
+        if(batch.size() > capacity)
+            capacity = batch.size() * 2;
+        api.bindBuffer(target.buffer);
+        api.streamBuffer(batch.data(), sizeof(CircleInstance) * batch.size(), sizeof(CircleInstance) * capacity);
+
+        api.bindVertexArray(target.vao);
+        api.drawIndexed(target.indexCount, batch.size());
+        api.bindVertexArray(0);
+        api.bindBuffer(0);
+        batch.clear();
+    }
+
+    template<typename Api>
+    inline void flushLineBatch(Api& api, const BatchTarget& target, const float projection[16],
+        LineBatch& batch, size_t& capacity)
+    {
+        if(batch.empty())
+            return;
+
+        api.useProgram(target.program);
+        api.uniformMatrix(target.projection, projection);
+
+        if(batch.vertexCount() > capacity)
+            capacity = batch.vertexCount() * 2;
+        api.bindBuffer(target.buffer);
+        api.streamBuffer(batch.data(), sizeof(LineVertex) * batch.vertexCount(), sizeof(LineVertex) * capacity);
+
+        // lines share the instancing shader with a constant identity instance
+        api.bindVertexArray(target.vao);
+        api.vertexAttrib(1, 0.0f, 0.0f, 1.0f);
+        api.drawLines(batch.vertexCount());
+        api.bindVertexArray(0);
+        api.bindBuffer(0);
+        batch.clear();
+    }
+
+} // namespace phy
+
+
+#endif
@@ -0,0 +1,335 @@
+/**
+ * Sort and sweep broadphase with collision layers. Proxies are grouped by
+ * their category bits; a pair of groups whose categories and masks never
+ * match is skipped without looking at a single proxy, and the remaining
+ * candidates are filtered per body before they are emitted.
+ *
+ * Given a JobSystem the groups are sorted in parallel and the sweeps run
+ * as jobs, the sweep of a group against itself cut in ranges of its sorted
+ * list. Each job emits into its own list and the lists are joined in the
+ * order a single thread would have emitted them.
+ */
+#ifndef __BYTENOL_PCGA_BROADPHASE_H__
+#define __BYTENOL_PCGA_BROADPHASE_H__
+
+#include <vector>
+#include <algorithm>
+#include "Vector.h"
+#include "JobSystem.h"
+
+namespace phy
+{
+    /// @brief Axis aligned bounding box
+    struct AABB
+    {
+        Vector2 min;
+        Vector2 max;
+
+        bool overlaps(const AABB& b) const;
+    };
+
+    /// @brief A body as seen by the broadphase
+    struct Proxy
+    {
+        AABB box;
+        unsigned int body = 0;              // index of the body owning the proxy
+        unsigned int category = 1;          // layers the body belongs to
+        unsigned int mask = 0xffffffff;     // layers the body collides with
+    };
+
+    struct BroadphasePair
+    {
+        unsigned int a;
+        unsigned int b;
+    };
+
+    struct BroadphaseStats
+    {
+        size_t candidatePairs = 0;  // pairs with overlapping boxes
+        size_t filteredPairs = 0;   // candidates dropped by category / mask
+        size_t skippedGroups = 0;   // group pairs skipped because their layers never collide
+    };
+
+    /// @brief true if both bodies accept each other's category
+    inline bool shouldCollide(const Proxy& a, const Proxy& b)
+    {
+        return (a.category & b.mask) != 0 && (b.category & a.mask) != 0;
+    }
+
+    class Broadphase
+    {
+        public:
+            /// @brief Remove all proxies, group storage is kept for the next frame
+            void clear();
+
+            void add(const Proxy& proxy);
+
+            /// @brief Size the pair list of every parallel sweep for pairCount pairs,
+            /// as any one of them may find nearly all of them
+            void reserve(size_t pairCount);
+
+            /// @brief Emit every overlapping pair whose layers collide
+            /// @param pairs is cleared and receives the body indices of each pair
+            /// @param jobs Runs the sort and the sweeps in parallel when given
+            void findPairs(std::vector<BroadphasePair>& pairs, JobSystem* jobs = nullptr);
+
+            /// @brief Call fn(const Proxy&) for every proxy whose box overlaps box, layers are ignored.
+            /// After findPairs the groups are sorted and each scan stops at the right edge of box
+            template<typename Fn>
+            void query(const AABB& box, Fn&& fn) const;
+
+            const BroadphaseStats& getStats() const;
+            const std::vector<Proxy>& getProxies() const;
+
+        private:
+            struct Group {
+                unsigned int category = 0;
+                unsigned int maskUnion = 0;     // union of the masks of every proxy in the group
+                std::vector<unsigned int> proxies;
+            };
+
+            /// @brief A sweep run as one job, g1 == g2 sweeps [begin, end) of a group against itself
+            struct SweepTask {
+                size_t g1, g2;
+                size_t begin, end;
+                std::vector<BroadphasePair> pairs;
+                BroadphaseStats stats;
+            };
+
+            void sweep(const Group& g, size_t begin, size_t end, std::vector<BroadphasePair>& pairs, BroadphaseStats& out);
+            void sweep(const Group& g1, const Group& g2, std::vector<BroadphasePair>& pairs, BroadphaseStats& out);
+            void emit(const Proxy& a, const Proxy& b, std::vector<BroadphasePair>& pairs, BroadphaseStats& out);
+            void addTask(size_t g1, size_t g2, size_t begin, size_t end);
+
+            std::vector<Proxy> proxies;
+            std::vector<Group> groups;
+            std::vector<SweepTask> tasks;   // only grows so the pair lists keep their storage
+            size_t taskCount = 0;
+            size_t reservedPairs = 0;
+            size_t groupCount = 0;
+            bool sorted = false;    // groups sorted by min.x, cleared by add
+            BroadphaseStats stats;
+    };
+
+
+    inline bool AABB::overlaps(const AABB& b) const
+    {
+        return min.x <= b.max.x && b.min.x <= max.x && min.y <= b.max.y && b.min.y <= max.y;
+    }
+
+    inline void Broadphase::clear()
+    {
+        proxies.clear();
+        for(auto& g: groups) {
+            g.proxies.clear();
+            g.maskUnion = 0;
+        }
+        groupCount = 0;
+    }
+
+    inline void Broadphase::add(const Proxy& proxy)
+    {
+        const unsigned int index = static_cast<unsigned int>(proxies.size());
+        proxies.push_back(proxy);
+
+        size_t g = 0;
+        while(g < groupCount && groups[g].category != proxy.category)
+            g++;
+
+        if(g == groupCount) {
+            if(groupCount == groups.size())
+                groups.emplace_back();
+            groups[g].category = proxy.category;
+            groupCount++;
+        }
+
+        groups[g].maskUnion |= proxy.mask;
+        groups[g].proxies.push_back(index);
+        sorted = false;
+    }
+
+    inline void Broadphase::findPairs(std::vector<BroadphasePair>& pairs, JobSystem* jobs)
+    {
+        pairs.clear();
+        stats = BroadphaseStats{};
+
+        parallelFor(jobs, groupCount, [this](size_t begin, size_t end, unsigned int) {
+            for(size_t g = begin; g < end; g++)
+            {
+                auto& list = groups[g].proxies;
+                std::sort(list.begin(), list.end(), [this](unsigned int a, unsigned int b) {
+                    return proxies[a].box.min.x < proxies[b].box.min.x;
+                });
+            }
+        }, 1);
+        sorted = true;
+
+        if(!jobs)
+        {
+            for(size_t g1 = 0; g1 < groupCount; g1++)
+            {
+                const Group& a = groups[g1];
+                if(a.category & a.maskUnion)
+                    sweep(a, 0, a.proxies.size(), pairs, stats);
+
+                for(size_t g2 = g1 + 1; g2 < groupCount; g2++)
+                {
+                    const Group& b = groups[g2];
+                    if((a.category & b.maskUnion) == 0 || (b.category & a.maskUnion) == 0) {
+                        stats.skippedGroups++;
+                        continue;
+                    }
+                    sweep(a, b, pairs, stats);
+                }
+            }
+            return;
+        }
+
+        // the same sweeps in the same order, as tasks
+        taskCount = 0;
+        for(size_t g1 = 0; g1 < groupCount; g1++)
+        {
+            const Group& a = groups[g1];
+            if(a.category & a.maskUnion) {
+                const size_t n = a.proxies.size();
+                const size_t chunk = std::max<size_t>(64, n / (jobs->threads() * JobSystem::chunksPerThread));
+                for(size_t begin = 0; begin < n; begin += chunk)
+                    addTask(g1, g1, begin, std::min(n, begin + chunk));
+            }
+
+            for(size_t g2 = g1 + 1; g2 < groupCount; g2++)
+            {
+                const Group& b = groups[g2];
+                if((a.category & b.maskUnion) == 0 || (b.category & a.maskUnion) == 0) {
+                    stats.skippedGroups++;
+                    continue;
+                }
+                addTask(g1, g2, 0, 0);
+            }
+        }
+
+        jobs->parallelFor(taskCount, [this](size_t begin, size_t end, unsigned int) {
+            for(size_t k = begin; k < end; k++)
+            {
+                auto& task = tasks[k];
+                task.pairs.clear();
+                task.stats = BroadphaseStats{};
+                if(task.g1 == task.g2)
+                    sweep(groups[task.g1], task.begin, task.end, task.pairs, task.stats);
+                else
+                    sweep(groups[task.g1], groups[task.g2], task.pairs, task.stats);
+            }
+        }, 1);
+
+        for(size_t k = 0; k < taskCount; k++)
+        {
+            const auto& task = tasks[k];
+            pairs.insert(pairs.end(), task.pairs.begin(), task.pairs.end());
+            stats.candidatePairs += task.stats.candidatePairs;
+            stats.filteredPairs += task.stats.filteredPairs;
+        }
+    }
+
+    inline void Broadphase::reserve(size_t pairCount)
+    {
+        reservedPairs = pairCount;
+        for(auto& task: tasks)
+            task.pairs.reserve(pairCount);
+    }
+
+    inline void Broadphase::addTask(size_t g1, size_t g2, size_t begin, size_t end)
+    {
+        if(taskCount == tasks.size()) {
+            tasks.emplace_back();
+            tasks.back().pairs.reserve(reservedPairs);
+        }
+        auto& task = tasks[taskCount++];
+        task.g1 = g1;
+        task.g2 = g2;
+        task.begin = begin;
+        task.end = end;
+    }
+
+    template<typename Fn>
+    inline void Broadphase::query(const AABB& box, Fn&& fn) const
+    {
+        for(size_t g = 0; g < groupCount; g++)
+        {
+            for(unsigned int i: groups[g].proxies)
+            {
+                const Proxy& p = proxies[i];
+                if(p.box.min.x > box.max.x) {
+                    if(sorted) break;
+                    continue;
+                }
+                if(p.box.overlaps(box))
+                    fn(p);
+            }
+        }
+    }
+
+    inline const BroadphaseStats& Broadphase::getStats() const
+    {
+        return stats;
+    }
+
+    inline const std::vector<Proxy>& Broadphase::getProxies() const
+    {
+        return proxies;
+    }
+
+    inline void Broadphase::sweep(const Group& g, size_t begin, size_t end, std::vector<BroadphasePair>& pairs, BroadphaseStats& out)
+    {
+        const auto& list = g.proxies;
+        for(size_t i = begin; i < end; i++)
+        {
+            const Proxy& a = proxies[list[i]];
+            for(size_t j = i + 1; j < list.size(); j++)
+            {
+                const Proxy& b = proxies[list[j]];
+                if(b.box.min.x > a.box.max.x)
+                    break;
+                if(a.box.min.y <= b.box.max.y && b.box.min.y <= a.box.max.y)
+                    emit(a, b, pairs, out);
+            }
+        }
+    }
+
+    inline void Broadphase::sweep(const Group& g1, const Group& g2, std::vector<BroadphasePair>& pairs, BroadphaseStats& out)
+    {
+        // merge the two sorted lists, each pair is found by whichever box starts first
+        const auto& l1 = g1.proxies;
+        const auto& l2 = g2.proxies;
+        size_t i = 0, j = 0;
+        while(i < l1.size() && j < l2.size())
+        {
+            const Proxy& a = proxies[l1[i]];
+            const Proxy& b = proxies[l2[j]];
+            if(a.box.min.x <= b.box.min.x) {
+                for(size_t k = j; k < l2.size() && proxies[l2[k]].box.min.x <= a.box.max.x; k++)
+                    if(a.box.min.y <= proxies[l2[k]].box.max.y && proxies[l2[k]].box.min.y <= a.box.max.y)
+                        emit(a, proxies[l2[k]], pairs, out);
+                i++;
+            } else {
+                for(size_t k = i; k < l1.size() && proxies[l1[k]].box.min.x <= b.box.max.x; k++)
+                    if(b.box.min.y <= proxies[l1[k]].box.max.y && proxies[l1[k]].box.min.y <= b.box.max.y)
+                        emit(proxies[l1[k]], b, pairs, out);
+                j++;
+            }
+        }
+    }
+
+    inline void Broadphase::emit(const Proxy& a, const Proxy& b, std::vector<BroadphasePair>& pairs, BroadphaseStats& out)
+    {
+        out.candidatePairs++;
+        if(!shouldCollide(a, b)) {
+            out.filteredPairs++;
+            return;
+        }
+        pairs.push_back({ a.body, b.body });
+    }
+
+} // namespace phy
+
+
+#endif
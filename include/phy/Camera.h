@@ -0,0 +1,129 @@
+/**
+ * 2D camera of the render layer. It maps world space to the screen with a
+ * pan and a zoom, and gives the world space box visible through the
+ * viewport so the renderer can ask a Broadphase for what to draw instead
+ * of walking every body.
+ */
+#ifndef __BYTENOL_PCGA_CAMERA_H__
+#define __BYTENOL_PCGA_CAMERA_H__
+
+#include <vector>
+#include <algorithm>
+#include "Vector.h"
+#include "Transform.h"
+#include "Broadphase.h"
+#include "DrawList.h"
+#include "World.h"
+
+namespace phy
+{
+    class Camera2D
+    {
+        public:
+            Vector2 center;         // world point at the middle of the viewport
+            float zoom = 1.0f;      // screen pixels per world unit
+            float minZoom = 0.05f;
+            float maxZoom = 20.0f;
+
+            Camera2D() = default;
+            Camera2D(float viewportWidth, float viewportHeight);
+
+            void setViewport(float width, float height);
+
+            /// @brief Move the view by a screen space offset
+            void pan(float dx, float dy);
+
+            /// @brief Scale the zoom by factor, keeping the world point under screenPoint in place
+            void zoomAt(float factor, const Vector2& screenPoint);
+
+            Vector2 worldToScreen(const Vector2& p) const;
+            Vector2 screenToWorld(const Vector2& p) const;
+
+            /// @brief World to screen transform, for Canvas2d::pushMatrix style backends
+            Affine2 transform() const;
+
+            /// @brief World space box seen through the viewport, grown by margin screen pixels
+            AABB visibleBounds(float margin = 0.0f) const;
+
+        private:
+            float width = 0.0f;
+            float height = 0.0f;
+    };
+
+    /// @brief Record the bodies of the world that the camera sees, in screen space.
+    /// Visibility comes from the broadphase of the last step, so only the bodies
+    /// near the view are touched. Polygons and circles are both drawn where that
+    /// broadphase saw them, the pose at the start of the last step, and nothing
+    /// is allocated once the list has grown to the frame
+    /// @return the number of bodies recorded
+    size_t drawVisible(const World& world, const Camera2D& camera, DrawList& list);
+
+
+    inline Camera2D::Camera2D(float viewportWidth, float viewportHeight)
+    {
+        setViewport(viewportWidth, viewportHeight);
+        center = { viewportWidth * 0.5f, viewportHeight * 0.5f };
+    }
+
+    inline void Camera2D::setViewport(float w, float h)
+    {
+        width = w;
+        height = h;
+    }
+
+    inline void Camera2D::pan(float dx, float dy)
+    {
+        center -= Vector2{ dx, dy } * (1.0f / zoom);
+    }
+
+    inline void Camera2D::zoomAt(float factor, const Vector2& screenPoint)
+    {
+        Vector2 anchor = screenToWorld(screenPoint);
+        zoom = std::clamp(zoom * factor, minZoom, maxZoom);
+        center += anchor - screenToWorld(screenPoint);
+    }
+
+    inline Vector2 Camera2D::worldToScreen(const Vector2& p) const
+    {
+        return { (p.x - center.x) * zoom + width * 0.5f, (p.y - center.y) * zoom + height * 0.5f };
+    }
+
+    inline Vector2 Camera2D::screenToWorld(const Vector2& p) const
+    {
+        return { (p.x - width * 0.5f) / zoom + center.x, (p.y - height * 0.5f) / zoom + center.y };
+    }
+
+    inline Affine2 Camera2D::transform() const
+    {
+        return { zoom, 0.0f, 0.0f, zoom, width * 0.5f - center.x * zoom, height * 0.5f - center.y * zoom };
+    }
+
+    inline AABB Camera2D::visibleBounds(float margin) const
+    {
+        return { screenToWorld({ -margin, -margin }), screenToWorld({ width + margin, height + margin }) };
+    }
+
+    inline size_t drawVisible(const World& world, const Camera2D& camera, DrawList& list)
+    {
+        size_t count = 0;
+        const Affine2 toScreen = camera.transform();
+        world.getBroadphase().query(camera.visibleBounds(1.0f), [&](const Proxy& proxy) {
+            const RigidBody& body = world.bodies[proxy.body];
+            const unsigned int color = (body.color.r << 16) | (body.color.g << 8) | body.color.b;
+            count++;
+
+            // the center of the proxy box, body.pos has moved on since the transformed vertices
+            if(body.vertices.empty()) {
+                Vector2 c = toScreen.apply((proxy.box.min + proxy.box.max) * 0.5f);
+                list.circle(c.x, c.y, body.radius * camera.zoom, color);
+                return;
+            }
+            list.polygon(body.transformed.data(), body.transformed.size(), toScreen, color);
+        });
+        return count;
+    }
+
+} // namespace phy
+
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * Checksums of the state of a World, to tell whether a change altered the
+ * simulation. Every body's position, velocity, rotation, angular velocity
+ * and sleep state is hashed (FNV-1a) after rounding to a quantum: with a
+ * quantum of 0 the raw bits are hashed and any difference shows, a larger
+ * quantum lets results that moved by less than it still match (values
+ * straddling a rounding boundary excepted).
+ *
+ * A record keeps a 32 bit hash per body next to the hash of the world so a
+ * mismatch can be traced to the first body that differs. Records are
+ * written one per line as text, which is what golden files hold.
+ */
+#ifndef __BYTENOL_PCGA_CHECKSUM_H__
+#define __BYTENOL_PCGA_CHECKSUM_H__
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <iomanip>
+#include "RigidBody.h"
+#include "World.h"
+
+namespace phy
+{
+    inline constexpr uint64_t fnvOffset = 0xcbf29ce484222325ull;
+    inline constexpr uint64_t fnvPrime = 0x100000001b3ull;
+
+    struct ChecksumRecord
+    {
+        int step = 0;
+        uint64_t world = 0;             // hash of every body hash, in order
+        std::vector<uint32_t> bodies;   // one hash per body
+    };
+
+    /// @brief FNV-1a over size bytes, continuing from hash
+    uint64_t fnv1a(const void* data, size_t size, uint64_t hash = fnvOffset);
+
+    /// @brief Hash of the state of one body rounded to quantum, the raw bits if quantum is 0
+    uint64_t hashBody(const RigidBody& body, float quantum);
+
+    ChecksumRecord checksum(const World& world, int step, float quantum);
+
+    /// @brief Index of the first body whose hash differs, -1 if the records
+    /// match and the common body count if only the number of bodies differs
+    long firstDivergence(const ChecksumRecord& expected, const ChecksumRecord& actual);
+
+    /// @brief "step world body0 body1 ..." in hexadecimal
+    void writeRecord(std::ostream& out, const ChecksumRecord& record);
+
+    /// @return false at the end of the stream or on a malformed line
+    bool readRecord(std::istream& in, ChecksumRecord& record);
+
+
+    inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for(size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= fnvPrime;
+        }
+        return hash;
+    }
+
+    inline uint64_t hashBody(const RigidBody& body, float quantum)
+    {
+        const float values[] = { body.pos.x, body.pos.y, body.vel.x, body.vel.y, body.rotation, body.angVel };
+        uint64_t hash = fnvOffset;
+        for(float v: values)
+        {
+            int64_t q;
+            if(quantum > 0.0f) {
+                q = std::llround(v / quantum);
+            } else {
+                uint32_t bits;
+                std::memcpy(&bits, &v, sizeof(bits));
+                q = bits;
+            }
+            hash = fnv1a(&q, sizeof(q), hash);
+        }
+
+        const unsigned char awake = body.awake;
+        return fnv1a(&awake, 1, hash);
+    }
+
+    inline ChecksumRecord checksum(const World& world, int step, float quantum)
+    {
+        ChecksumRecord record;
+        record.step = step;
+        record.world = fnvOffset;
+        record.bodies.reserve(world.bodies.size());
+        for(const auto& body: world.bodies)
+        {
+            uint64_t h = hashBody(body, quantum);
+            record.bodies.push_back(static_cast<uint32_t>(h ^ (h >> 32)));
+            record.world = fnv1a(&h, sizeof(h), record.world);
+        }
+        return record;
+    }
+
+    inline long firstDivergence(const ChecksumRecord& expected, const ChecksumRecord& actual)
+    {
+        const size_t n = std::min(expected.bodies.size(), actual.bodies.size());
+        for(size_t i = 0; i < n; i++)
+            if(expected.bodies[i] != actual.bodies[i])
+                return static_cast<long>(i);
+        if(expected.bodies.size() != actual.bodies.size() || expected.world != actual.world)
+            return static_cast<long>(n);
+        return -1;
+    }
+
+    inline void writeRecord(std::ostream& out, const ChecksumRecord& record)
+    {
+        out << std::dec << record.step << " " << std::hex << std::setfill('0') << std::setw(16) << record.world;
+        for(auto h: record.bodies)
+            out << " " << std::setw(8) << h;
+        out << std::dec << std::setfill(' ') << "\n";
+    }
+
+    inline bool readRecord(std::istream& in, ChecksumRecord& record)
+    {
+        std::string line;
+        while(std::getline(in, line))
+        {
+            if(line.empty() || line[0] == '#')
+                continue;
+
+            // hex hashes are parsed by hand, a stream stops at the first bad one
+            record = ChecksumRecord{};
+            char* end = nullptr;
+            record.step = static_cast<int>(std::strtol(line.c_str(), &end, 10));
+            if(end == line.c_str())
+                return false;
+            const char* p = end;
+            record.world = std::strtoull(p, &end, 16);
+            if(end == p)
+                return false;
+            for(p = end;; p = end) {
+                unsigned long h = std::strtoul(p, &end, 16);
+                if(end == p)
+                    break;
+                record.bodies.push_back(static_cast<uint32_t>(h));
+            }
+            return true;
+        }
+        return false;
+    }
+
+} // namespace phy
+
+
+#endif
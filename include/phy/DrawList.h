@@ -0,0 +1,211 @@
+/**
+ * Renderer agnostic draw commands. Physics types and debug views record
+ * plain POD commands into a DrawList and never see a graphics api; a
+ * backend (SDL, Canvas2d, SoftwareRenderer or NullBackend) consumes the
+ * list afterwards. Sorting the list by primitive, color and alpha lets every
+ * backend turn runs of equal commands into a single submission.
+ */
+#ifndef __BYTENOL_PCGA_DRAW_LIST_H__
+#define __BYTENOL_PCGA_DRAW_LIST_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include "Vector.h"
+#include "Transform.h"
+
+namespace phy
+{
+    enum class DrawPrimitive : unsigned char
+    {
+        Circle = 0,         // filled circle
+        CircleOutline,
+        Line,
+        Polygon,            // filled polygon
+        Count
+    };
+
+    /// @brief A single draw command, trivially copyable
+    struct DrawCommand
+    {
+        DrawPrimitive type;
+        unsigned int color;     // 0xrrggbb
+        float alpha;
+        float x1, y1;           // circle center or line start
+        float x2, y2;           // circle radius in x2 or line end
+        uint32_t first;         // polygon: range in DrawList::getVertices
+        uint32_t count;
+
+        /// @brief Alpha as the backends draw it, 0 to 255
+        uint8_t alpha8() const;
+
+        /// @brief Sort key grouping commands by primitive, then color and alpha
+        uint64_t key() const;
+    };
+
+    class DrawList
+    {
+        public:
+            void circle(float x, float y, float radius, unsigned int hex, float alpha = 1.0f);
+            void circleOutline(float x, float y, float radius, unsigned int hex, float alpha = 1.0f);
+            void line(float x1, float y1, float x2, float y2, unsigned int hex, float alpha = 1.0f);
+
+            /// @brief Filled convex polygon, the vertices are copied
+            void polygon(const Vector2* vertices, size_t count, unsigned int hex, float alpha = 1.0f);
+
+            /// @brief Filled convex polygon, the vertices are stored through m
+            void polygon(const Vector2* vertices, size_t count, const Affine2& m, unsigned int hex, float alpha = 1.0f);
+
+            /// @brief Group the commands by primitive, color and alpha, keeping the order of equal keys.
+            /// Only sort when the paint order of overlapping shapes does not matter
+            void sort();
+
+            /// @brief Remove every command, storage is kept for the next frame
+            void clear();
+
+            bool empty() const;
+            size_t size() const;
+            const std::vector<DrawCommand>& getCommands() const;
+            const std::vector<Vector2>& getVertices() const;
+
+        private:
+            std::vector<DrawCommand> commands;
+            std::vector<Vector2> vertices;
+            std::vector<DrawCommand> scratch;
+    };
+
+    /// @brief Backend that only counts what it is given, used to time the simulation alone
+    class NullBackend
+    {
+        public:
+            void submit(const DrawList& list);
+
+            size_t getCommands() const;
+            size_t getVertices() const;
+            void reset();
+
+        private:
+            size_t commands = 0;
+            size_t vertices = 0;
+    };
+
+
+    inline uint8_t DrawCommand::alpha8() const
+    {
+        return static_cast<uint8_t>(std::clamp(alpha, 0.0f, 1.0f) * 255.0f);
+    }
+
+    inline uint64_t DrawCommand::key() const
+    {
+        return (static_cast<uint64_t>(type) << 32) | ((color & 0xffffff) << 8) | alpha8();
+    }
+
+    inline void DrawList::circle(float x, float y, float radius, unsigned int hex, float alpha)
+    {
+        commands.push_back({ DrawPrimitive::Circle, hex, alpha, x, y, radius, 0.0f, 0, 0 });
+    }
+
+    inline void DrawList::circleOutline(float x, float y, float radius, unsigned int hex, float alpha)
+    {
+        commands.push_back({ DrawPrimitive::CircleOutline, hex, alpha, x, y, radius, 0.0f, 0, 0 });
+    }
+
+    inline void DrawList::line(float x1, float y1, float x2, float y2, unsigned int hex, float alpha)
+    {
+        commands.push_back({ DrawPrimitive::Line, hex, alpha, x1, y1, x2, y2, 0, 0 });
+    }
+
+    inline void DrawList::polygon(const Vector2* v, size_t count, unsigned int hex, float alpha)
+    {
+        if(count < 3)
+            return;
+        commands.push_back({ DrawPrimitive::Polygon, hex, alpha, 0.0f, 0.0f, 0.0f, 0.0f,
+            static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(count) });
+        vertices.insert(vertices.end(), v, v + count);
+    }
+
+    inline void DrawList::polygon(const Vector2* v, size_t count, const Affine2& m, unsigned int hex, float alpha)
+    {
+        if(count < 3)
+            return;
+        commands.push_back({ DrawPrimitive::Polygon, hex, alpha, 0.0f, 0.0f, 0.0f, 0.0f,
+            static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(count) });
+        for(size_t i = 0; i < count; i++)
+            vertices.push_back(m.apply(v[i]));
+    }
+
+    inline void DrawList::sort()
+    {
+        // counting sort on the primitive, then a stable sort of each run by color and alpha
+        size_t offsets[(int)DrawPrimitive::Count + 1] = {};
+        for(const auto& c: commands)
+            offsets[(int)c.type + 1]++;
+        for(int i = 0; i < (int)DrawPrimitive::Count; i++)
+            offsets[i + 1] += offsets[i];
+
+        scratch.resize(commands.size());
+        size_t cursor[(int)DrawPrimitive::Count];
+        std::copy(offsets, offsets + (int)DrawPrimitive::Count, cursor);
+        for(const auto& c: commands)
+            scratch[cursor[(int)c.type]++] = c;
+
+        for(int i = 0; i < (int)DrawPrimitive::Count; i++)
+            std::stable_sort(scratch.begin() + offsets[i], scratch.begin() + offsets[i + 1],
+                [](const DrawCommand& a, const DrawCommand& b) { return a.key() < b.key(); });
+
+        commands.swap(scratch);
+    }
+
+    inline void DrawList::clear()
+    {
+        commands.clear();
+        vertices.clear();
+    }
+
+    inline bool DrawList::empty() const
+    {
+        return commands.empty();
+    }
+
+    inline size_t DrawList::size() const
+    {
+        return commands.size();
+    }
+
+    inline const std::vector<DrawCommand>& DrawList::getCommands() const
+    {
+        return commands;
+    }
+
+    inline const std::vector<Vector2>& DrawList::getVertices() const
+    {
+        return vertices;
+    }
+
+    inline void NullBackend::submit(const DrawList& list)
+    {
+        commands += list.size();
+        vertices += list.getVertices().size();
+    }
+
+    inline size_t NullBackend::getCommands() const
+    {
+        return commands;
+    }
+
+    inline size_t NullBackend::getVertices() const
+    {
+        return vertices;
+    }
+
+    inline void NullBackend::reset()
+    {
+        commands = 0;
+        vertices = 0;
+    }
+
+} // namespace phy
+
+
+#endif
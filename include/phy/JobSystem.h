@@ -0,0 +1,404 @@
+/**
+ * Work stealing job system. Every thread of the system owns a Chase-Lev
+ * deque: it pushes and pops jobs at the bottom of its own deque while idle
+ * threads steal from the top of the others, so the owner works on the
+ * freshest (cache warm) jobs and thieves take the oldest, largest ones.
+ *
+ * A JobCounter is the fork-join point: each job submitted against it adds
+ * one, each finished job takes one away, and wait() runs other jobs until
+ * it reaches zero instead of blocking. parallelFor splits a range into
+ * chunks (a few per thread unless a grain is given) on top of the two.
+ *
+ * The thread creating the system is thread 0 and takes part in the work
+ * whenever it waits; threads - 1 workers are started next to it and sleep
+ * while there is nothing to do, so the system can be sized to leave cores
+ * to the other threads of an engine. Jobs live in fixed pools and deques
+ * never grow: submitting never allocates. A slot of a pool is only reused
+ * once its job finished, a job left at the top of a deque is stepped over.
+ */
+#ifndef __BYTENOL_PCGA_JOB_SYSTEM_H__
+#define __BYTENOL_PCGA_JOB_SYSTEM_H__
+
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+namespace phy
+{
+    /// @brief Work of a job: the range [begin, end) of whatever data points to
+    using JobFunction = void (*)(void* data, size_t begin, size_t end, unsigned int thread);
+
+    /// @brief Number of unfinished jobs of a fork, wait on it to join
+    class JobCounter
+    {
+        public:
+            bool done() const;
+
+        private:
+            friend class JobSystem;
+            std::atomic<int> pending{ 0 };
+    };
+
+    struct Job
+    {
+        JobFunction function = nullptr;
+        void* data = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        JobCounter* counter = nullptr;
+        std::atomic<bool> busy{ false };    // from the push until the job finished
+    };
+
+    /**
+     * Chase-Lev deque of a fixed capacity (Lê, Pop, Cohen, Zappa Nardelli,
+     * "Correct and Efficient Work-Stealing for Weak Memory Models"), with
+     * sequentially consistent accesses in place of the fences of the paper.
+     * push() and pop() belong to the owner thread, steal() to any other.
+     */
+    class JobDeque
+    {
+        public:
+            static constexpr int64_t capacity = 4096;
+
+            /// @return false if the deque is full
+            bool push(Job* job);
+            Job* pop();
+            Job* steal();
+
+            /// @brief Only meaningful on the owner thread, thieves can only make it emptier
+            bool full() const;
+
+        private:
+            alignas(64) std::atomic<int64_t> top{ 0 };
+            alignas(64) std::atomic<int64_t> bottom{ 0 };
+            std::atomic<Job*> buffer[capacity];
+    };
+
+    class JobSystem;
+
+    namespace detail
+    {
+        /// @brief The system the calling thread works for and its index there
+        struct JobThread
+        {
+            const JobSystem* system = nullptr;
+            unsigned int thread = 0;
+        };
+
+        inline thread_local JobThread jobThread;
+    }
+
+    class JobSystem
+    {
+        public:
+            /// @param threads threads taking part, the calling one included,
+            /// 0 picks std::thread::hardware_concurrency
+            explicit JobSystem(unsigned int threads = 0);
+            ~JobSystem();
+
+            JobSystem(const JobSystem&) = delete;
+            JobSystem& operator=(const JobSystem&) = delete;
+
+            unsigned int threads() const;
+
+            /// @brief Index of the calling thread in [0, threads()), -1 if it is not one of them
+            int currentThread() const;
+
+            /// @brief Queue function(data, begin, end, thread) against counter, data must
+            /// outlive the wait. Runs it at once when the queue is full or the caller
+            /// is not a thread of the system.
+            void run(JobCounter& counter, JobFunction function, void* data, size_t begin = 0, size_t end = 0);
+
+            /// @brief Run queued and stolen jobs until every job of counter finished
+            void wait(JobCounter& counter);
+
+            /// @brief Call fn(begin, end, thread) over chunks of [0, count) and wait for all of them
+            /// @param grain Chunk size, 0 makes chunksPerThread chunks per thread
+            template<typename Fn>
+            void parallelFor(size_t count, Fn&& fn, size_t grain = 0);
+
+            static constexpr size_t chunksPerThread = 4;
+
+        private:
+            struct alignas(64) Worker
+            {
+                JobDeque deque;
+                Job jobs[JobDeque::capacity];   // ring of job storage, busy slots are skipped
+                uint64_t nextJob = 0;
+                uint32_t random = 0;            // picks the victims of steal attempts
+            };
+
+            /// @brief Queue without waking the workers
+            bool push(unsigned int thread, JobCounter& counter, JobFunction function, void* data, size_t begin, size_t end);
+            void wake();
+            Job* next(unsigned int thread);
+            void execute(Job* job, unsigned int thread);
+            void workerLoop(unsigned int thread);
+
+            unsigned int threadCount;
+            std::unique_ptr<Worker[]> workers;
+            std::vector<std::thread> pool;
+            std::atomic<bool> quit{ false };
+            std::atomic<uint32_t> wakeups{ 0 };
+            std::atomic<unsigned int> sleeping{ 0 };
+    };
+
+    /// @brief JobSystem::parallelFor, or fn(0, count, 0) on the calling thread without a system
+    template<typename Fn>
+    void parallelFor(JobSystem* jobs, size_t count, Fn&& fn, size_t grain = 0);
+
+
+    inline bool JobCounter::done() const
+    {
+        return pending.load(std::memory_order_acquire) == 0;
+    }
+
+    inline bool JobDeque::push(Job* job)
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if(b - t >= capacity)
+            return false;
+        buffer[b & (capacity - 1)].store(job, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    inline bool JobDeque::full() const
+    {
+        return bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_acquire) >= capacity;
+    }
+
+    inline Job* JobDeque::pop()
+    {
+        // the store and the load must not be reordered, or a thief and the
+        // owner could both take the last job
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_seq_cst);
+
+        if(t > b) {
+            // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job* job = buffer[b & (capacity - 1)].load(std::memory_order_relaxed);
+        if(t == b) {
+            // the last job, race the thieves for it
+            if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    inline Job* JobDeque::steal()
+    {
+        int64_t t = top.load(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_seq_cst);
+        if(t >= b)
+            return nullptr;
+
+        Job* job = buffer[t & (capacity - 1)].load(std::memory_order_relaxed);
+        if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return job;
+    }
+
+    inline JobSystem::JobSystem(unsigned int threads)
+    {
+        threadCount = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        workers = std::make_unique<Worker[]>(threadCount);
+        for(unsigned int i = 0; i < threadCount; i++)
+            workers[i].random = 0x9e3779b9u * (i + 1);
+
+        detail::jobThread = { this, 0 };
+        for(unsigned int i = 1; i < threadCount; i++)
+            pool.emplace_back([this, i]() { workerLoop(i); });
+    }
+
+    inline JobSystem::~JobSystem()
+    {
+        quit.store(true);
+        wakeups.fetch_add(1);
+        wakeups.notify_all();
+        for(auto& thread: pool)
+            thread.join();
+        if(detail::jobThread.system == this)
+            detail::jobThread = {};
+    }
+
+    inline unsigned int JobSystem::threads() const
+    {
+        return threadCount;
+    }
+
+    inline int JobSystem::currentThread() const
+    {
+        return detail::jobThread.system == this ? static_cast<int>(detail::jobThread.thread) : -1;
+    }
+
+    inline bool JobSystem::push(unsigned int thread, JobCounter& counter, JobFunction function, void* data, size_t begin, size_t end)
+    {
+        Worker& w = workers[thread];
+        if(w.deque.full())
+            return false;
+
+        // the next slot of the ring is free unless an old job is still queued or
+        // running, that one is stepped over; when every slot is busy the caller runs it
+        for(int64_t k = 0; k < JobDeque::capacity; k++)
+        {
+            Job& job = w.jobs[w.nextJob++ & (JobDeque::capacity - 1)];
+            if(job.busy.load(std::memory_order_acquire))
+                continue;
+
+            job.function = function;
+            job.data = data;
+            job.begin = begin;
+            job.end = end;
+            job.counter = &counter;
+            job.busy.store(true, std::memory_order_relaxed);
+            counter.pending.fetch_add(1, std::memory_order_relaxed);
+            w.deque.push(&job);
+            return true;
+        }
+        return false;
+    }
+
+    inline void JobSystem::wake()
+    {
+        // a worker about to sleep either sees the new generation or is counted in sleeping
+        wakeups.fetch_add(1);
+        if(sleeping.load() > 0)
+            wakeups.notify_all();
+    }
+
+    inline void JobSystem::run(JobCounter& counter, JobFunction function, void* data, size_t begin, size_t end)
+    {
+        const int thread = currentThread();
+        if(thread < 0 || !push(thread, counter, function, data, begin, end)) {
+            function(data, begin, end, thread < 0 ? 0 : thread);
+            return;
+        }
+        wake();
+    }
+
+    inline Job* JobSystem::next(unsigned int thread)
+    {
+        Worker& w = workers[thread];
+        if(Job* job = w.deque.pop())
+            return job;
+
+        // xorshift picks where to start, then every other deque is tried once
+        w.random ^= w.random << 13;
+        w.random ^= w.random >> 17;
+        w.random ^= w.random << 5;
+        const unsigned int start = w.random % threadCount;
+        for(unsigned int k = 0; k < threadCount; k++)
+        {
+            const unsigned int victim = (start + k) % threadCount;
+            if(victim == thread)
+                continue;
+            if(Job* job = workers[victim].deque.steal())
+                return job;
+        }
+        return nullptr;
+    }
+
+    inline void JobSystem::execute(Job* job, unsigned int thread)
+    {
+        // copied out, the owner may reuse the slot as soon as it is no longer busy
+        JobCounter* counter = job->counter;
+        job->function(job->data, job->begin, job->end, thread);
+        job->busy.store(false, std::memory_order_release);
+        counter->pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    inline void JobSystem::wait(JobCounter& counter)
+    {
+        const int thread = currentThread();
+        while(!counter.done())
+        {
+            Job* job = thread >= 0 ? next(thread) : nullptr;
+            if(job)
+                execute(job, thread);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    inline void JobSystem::workerLoop(unsigned int thread)
+    {
+        detail::jobThread = { this, thread };
+        while(!quit.load(std::memory_order_relaxed))
+        {
+            const uint32_t seen = wakeups.load();
+            if(Job* job = next(thread)) {
+                execute(job, thread);
+                continue;
+            }
+
+            sleeping.fetch_add(1);
+            if(Job* job = next(thread)) {
+                sleeping.fetch_sub(1);
+                execute(job, thread);
+                continue;
+            }
+            if(!quit.load())
+                wakeups.wait(seen);
+            sleeping.fetch_sub(1);
+        }
+    }
+
+    template<typename Fn>
+    inline void JobSystem::parallelFor(size_t count, Fn&& fn, size_t grain)
+    {
+        if(count == 0)
+            return;
+
+        const int thread = currentThread();
+        if(grain == 0)
+            grain = std::max<size_t>(1, count / (threadCount * chunksPerThread));
+        if(thread < 0 || threadCount == 1 || count <= grain) {
+            fn(size_t(0), count, thread < 0 ? 0u : static_cast<unsigned int>(thread));
+            return;
+        }
+
+        using F = std::remove_reference_t<Fn>;
+        JobFunction call = [](void* data, size_t begin, size_t end, unsigned int t) {
+            (*static_cast<F*>(data))(begin, end, t);
+        };
+        void* data = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+
+        // the caller keeps the first chunk, the others go to its deque to be stolen
+        JobCounter counter;
+        for(size_t begin = grain; begin < count; begin += grain)
+        {
+            const size_t end = std::min(count, begin + grain);
+            if(!push(thread, counter, call, data, begin, end))
+                fn(begin, end, static_cast<unsigned int>(thread));
+        }
+        wake();
+
+        fn(size_t(0), grain, static_cast<unsigned int>(thread));
+        wait(counter);
+    }
+
+    template<typename Fn>
+    inline void parallelFor(JobSystem* jobs, size_t count, Fn&& fn, size_t grain)
+    {
+        if(jobs)
+            jobs->parallelFor(count, std::forward<Fn>(fn), grain);
+        else if(count > 0)
+            fn(size_t(0), count, 0u);
+    }
+
+} // namespace phy
+
+
+#endif
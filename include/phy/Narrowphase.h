@@ -0,0 +1,303 @@
+/**
+ * Narrowphase collision with contact manifolds. Every shape pair goes
+ * through a [ShapeType][ShapeType] dispatch table so circles (both the
+ * SDL phy::Ball and the OpenGL phy::Ball from phy.h) get closed form tests
+ * and only polygon-polygon pairs run the separating axis test.
+ */
+#ifndef __BYTENOL_PCGA_NARROWPHASE_H__
+#define __BYTENOL_PCGA_NARROWPHASE_H__
+
+#include <vector>
+#include <cmath>
+#include <utility>
+#include <algorithm>
+#include "Vector.h"
+
+namespace phy
+{
+    enum class ShapeType : unsigned char
+    {
+        Circle = 0,
+        Polygon,
+        Count
+    };
+
+    /// @brief Lightweight view of a body's collision shape in world space
+    struct Shape
+    {
+        ShapeType type = ShapeType::Circle;
+        Vector2 center;                     // circle center or polygon position
+        float radius = 0.0f;                // circle radius
+        const Vector2* vertices = nullptr;  // world space polygon vertices
+        unsigned int count = 0;
+    };
+
+    /// @brief Contact information of an overlapping pair
+    struct Manifold
+    {
+        Vector2 normal;         // points from the first shape toward the second one
+        float depth = 0.0f;     // deepest penetration along normal
+        Vector2 points[2];
+        int pointCount = 0;
+        unsigned int axesTested = 0;    // separating axes tried, set whether or not the shapes touch
+    };
+
+    using CollideFn = bool (*)(const Shape& a, const Shape& b, Manifold& m);
+
+    bool collideCircles(const Shape& a, const Shape& b, Manifold& m);
+    bool collideCirclePolygon(const Shape& a, const Shape& b, Manifold& m);
+    bool collidePolygonCircle(const Shape& a, const Shape& b, Manifold& m);
+    bool collidePolygons(const Shape& a, const Shape& b, Manifold& m);
+
+    /// @brief Collision functions indexed by [a.type][b.type]
+    inline constexpr CollideFn collisionTable[(int)ShapeType::Count][(int)ShapeType::Count] = {
+        { collideCircles, collideCirclePolygon },
+        { collidePolygonCircle, collidePolygons },
+    };
+
+    /// @brief Test two shapes and fill the manifold if they overlap
+    /// @return true if there is any collision
+    inline bool collide(const Shape& a, const Shape& b, Manifold& m)
+    {
+        return collisionTable[(int)a.type][(int)b.type](a, b, m);
+    }
+
+    /// @brief Circle shape of any ball with pos.x, pos.y and radius
+    template<typename BallType>
+    inline Shape circleShape(const BallType& ball)
+    {
+        Shape s;
+        s.type = ShapeType::Circle;
+        s.center = { ball.pos.x, ball.pos.y };
+        s.radius = static_cast<float>(ball.radius);
+        return s;
+    }
+
+    /// @brief Polygon shape over world space vertices, they must outlive the shape
+    inline Shape polygonShape(const Vector2& pos, const std::vector<Vector2>& transformed)
+    {
+        Shape s;
+        s.type = ShapeType::Polygon;
+        s.center = pos;
+        s.vertices = transformed.data();
+        s.count = static_cast<unsigned int>(transformed.size());
+        return s;
+    }
+
+
+    inline bool collideCircles(const Shape& a, const Shape& b, Manifold& m)
+    {
+        Vector2 d = b.center - a.center;
+        float r = a.radius + b.radius;
+        float d2 = d.dotProduct(d);
+        if(d2 > r * r)
+            return false;
+
+        float dist = std::sqrt(d2);
+        m.normal = dist > 0.0f ? d * (1.0f / dist) : Vector2{ 1.0f, 0.0f };
+        m.depth = r - dist;
+        m.points[0] = a.center + m.normal * (a.radius - m.depth * 0.5f);
+        m.pointCount = 1;
+        return true;
+    }
+
+    /// @brief Outward normal of edge i, works for both windings
+    inline Vector2 edgeNormal(const Shape& p, unsigned int i, float winding)
+    {
+        auto e = p.vertices[(i + 1) % p.count] - p.vertices[i];
+        return Vector2{ e.y * winding, -e.x * winding }.normalize();
+    }
+
+    /// @brief 1 for counter clockwise vertices (in a y up frame), -1 otherwise
+    inline float polygonWinding(const Shape& p)
+    {
+        float area = 0.0f;
+        for(unsigned int i = 0; i < p.count; i++) {
+            const auto& v1 = p.vertices[i];
+            const auto& v2 = p.vertices[(i + 1) % p.count];
+            area += v1.x * v2.y - v2.x * v1.y;
+        }
+        return area >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    inline bool collideCirclePolygon(const Shape& a, const Shape& b, Manifold& m)
+    {
+        const float winding = polygonWinding(b);
+        const Vector2& c = a.center;
+
+        // face of least penetration
+        float separation = -INFINITY;
+        unsigned int face = 0;
+        for(unsigned int i = 0; i < b.count; i++)
+        {
+            float s = edgeNormal(b, i, winding).dotProduct(c - b.vertices[i]);
+            if(s > a.radius) {
+                m.axesTested = i + 1;
+                return false;
+            }
+            if(s > separation) {
+                separation = s;
+                face = i;
+            }
+        }
+        m.axesTested = b.count;
+
+        const Vector2& v1 = b.vertices[face];
+        const Vector2& v2 = b.vertices[(face + 1) % b.count];
+        Vector2 n = edgeNormal(b, face, winding);
+
+        // center inside the polygon
+        if(separation < 0.0f) {
+            m.normal = n * -1.0f;
+            m.depth = a.radius - separation;
+            m.points[0] = c - n * separation;
+            m.pointCount = 1;
+            return true;
+        }
+
+        // voronoi regions of the face and its two corners
+        Vector2 closest;
+        Vector2 edge = v2 - v1;
+        float u = (c - v1).dotProduct(edge);
+        if(u <= 0.0f) closest = v1;
+        else if(u >= edge.dotProduct(edge)) closest = v2;
+        else closest = c - n * separation;
+
+        Vector2 d = closest - c;
+        float dist = d.getLength();
+        if(dist > a.radius)
+            return false;
+
+        m.normal = dist > 0.0f ? d * (1.0f / dist) : n * -1.0f;
+        m.depth = a.radius - dist;
+        m.points[0] = closest;
+        m.pointCount = 1;
+        return true;
+    }
+
+    inline bool collidePolygonCircle(const Shape& a, const Shape& b, Manifold& m)
+    {
+        if(!collideCirclePolygon(b, a, m))
+            return false;
+        m.normal *= -1.0f;
+        return true;
+    }
+
+    /// @brief Largest separation of q along the face normals of p
+    inline float maxSeparation(const Shape& p, float windingP, const Shape& q, unsigned int& face)
+    {
+        float best = -INFINITY;
+        for(unsigned int i = 0; i < p.count; i++)
+        {
+            Vector2 n = edgeNormal(p, i, windingP);
+            float s = INFINITY;
+            for(unsigned int j = 0; j < q.count; j++)
+                s = std::min(s, n.dotProduct(q.vertices[j] - p.vertices[i]));
+            if(s > best) {
+                best = s;
+                face = i;
+            }
+            if(best > 0.0f)
+                break;
+        }
+        return best;
+    }
+
+    /// @brief Keep the part of segment in where dir . p <= offset
+    inline int clipSegment(const Vector2 in[2], Vector2 out[2], const Vector2& dir, float offset)
+    {
+        int n = 0;
+        float d0 = dir.dotProduct(in[0]) - offset;
+        float d1 = dir.dotProduct(in[1]) - offset;
+        if(d0 <= 0.0f) out[n++] = in[0];
+        if(d1 <= 0.0f) out[n++] = in[1];
+        if(d0 * d1 < 0.0f)
+            out[n++] = in[0] + (in[1] - in[0]) * (d0 / (d0 - d1));
+        return n;
+    }
+
+    inline bool collidePolygons(const Shape& a, const Shape& b, Manifold& m)
+    {
+        const float windingA = polygonWinding(a);
+        const float windingB = polygonWinding(b);
+
+        unsigned int faceA = 0, faceB = 0;
+        // maxSeparation stops at the first separating face
+        float sepA = maxSeparation(a, windingA, b, faceA);
+        m.axesTested = sepA > 0.0f ? faceA + 1 : a.count;
+        if(sepA > 0.0f) return false;
+        float sepB = maxSeparation(b, windingB, a, faceB);
+        m.axesTested += sepB > 0.0f ? faceB + 1 : b.count;
+        if(sepB > 0.0f) return false;
+
+        // reference face is the axis of least penetration, with a small bias
+        // toward a so the manifold does not flip between frames
+        const Shape* ref = &a;
+        const Shape* inc = &b;
+        float windingRef = windingA, windingInc = windingB;
+        unsigned int face = faceA;
+        bool flip = false;
+        if(sepB > sepA * 0.98f + 0.001f) {
+            std::swap(ref, inc);
+            std::swap(windingRef, windingInc);
+            face = faceB;
+            flip = true;
+        }
+
+        Vector2 n = edgeNormal(*ref, face, windingRef);
+
+        // incident face is the one most anti parallel to the reference normal
+        unsigned int incFace = 0;
+        float minDot = INFINITY;
+        for(unsigned int i = 0; i < inc->count; i++) {
+            float d = edgeNormal(*inc, i, windingInc).dotProduct(n);
+            if(d < minDot) {
+                minDot = d;
+                incFace = i;
+            }
+        }
+
+        Vector2 incident[2] = { inc->vertices[incFace], inc->vertices[(incFace + 1) % inc->count] };
+        const Vector2& v1 = ref->vertices[face];
+        const Vector2& v2 = ref->vertices[(face + 1) % ref->count];
+        Vector2 tangent = (v2 - v1).normalize();
+
+        // clip the incident face against the side planes of the reference face
+        Vector2 clip1[3], clip2[3];
+        const bool clipped = clipSegment(incident, clip1, tangent * -1.0f, -tangent.dotProduct(v1)) >= 2 &&
+            clipSegment(clip1, clip2, tangent, tangent.dotProduct(v2)) >= 2;
+
+        m.pointCount = 0;
+        m.depth = 0.0f;
+        for(int i = 0; clipped && i < 2; i++)
+        {
+            float s = n.dotProduct(clip2[i] - v1);
+            if(s <= 0.0f) {
+                m.points[m.pointCount++] = clip2[i];
+                m.depth = std::max(m.depth, -s);
+            }
+        }
+
+        // with one polygon deep inside the other the incident face can miss the
+        // reference face entirely, the deepest incident vertex is then the contact
+        if(m.pointCount == 0) {
+            float deepest = INFINITY;
+            for(unsigned int i = 0; i < inc->count; i++) {
+                float s = n.dotProduct(inc->vertices[i] - v1);
+                if(s < deepest) {
+                    deepest = s;
+                    m.points[0] = inc->vertices[i];
+                }
+            }
+            m.depth = std::max(-deepest, 0.0f);
+            m.pointCount = 1;
+        }
+
+        m.normal = flip ? n * -1.0f : n;
+        return true;
+    }
+
+} // namespace phy
+
+
+#endif
@@ -0,0 +1,234 @@
+/**
+ * Hardware performance counters of the calling thread through Linux
+ * perf_event_open. The events are opened as one group so they are
+ * scheduled on the PMU together and their ratios (IPC, misses per
+ * instruction) describe the same instructions; when the kernel multiplexes
+ * the group the values are scaled by the time it actually ran.
+ *
+ * Only user space is counted so the default perf_event_paranoid of 2 is
+ * enough. Events the CPU or the kernel refuse are left out, and where
+ * nothing can be opened (other systems, containers, paranoid 3) the group
+ * reports it is unavailable and every count reads as zero.
+ */
+#ifndef __BYTENOL_PCGA_PERF_COUNTERS_H__
+#define __BYTENOL_PCGA_PERF_COUNTERS_H__
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace phy
+{
+    enum class PerfEvent : unsigned int
+    {
+        Cycles = 0,
+        Instructions,
+        CacheReferences,
+        CacheMisses,
+        BranchInstructions,
+        BranchMisses,
+        Count
+    };
+
+    inline constexpr const char* perfEventNames[] = {
+        "cycles", "instructions", "cache_references", "cache_misses", "branches", "branch_misses"
+    };
+
+    struct PerfSample
+    {
+        std::array<uint64_t, (size_t)PerfEvent::Count> values{};
+        std::array<bool, (size_t)PerfEvent::Count> valid{};
+
+        uint64_t operator[](PerfEvent e) const;
+        bool has(PerfEvent e) const;
+
+        /// @brief Instructions per cycle, 0 without both counters
+        double ipc() const;
+
+        PerfSample& operator+=(const PerfSample& other);
+    };
+
+    class PerfCounterGroup
+    {
+        public:
+            PerfCounterGroup();
+            ~PerfCounterGroup();
+
+            PerfCounterGroup(const PerfCounterGroup&) = delete;
+            PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+            /// @return true if at least one event could be opened
+            bool available() const;
+
+            /// @brief Why the group is unavailable or incomplete, empty if every event opened
+            const std::string& getError() const;
+
+            /// @brief Reset and enable every counter of the group
+            void start();
+
+            /// @brief Disable the group and read the counts since start()
+            PerfSample stop();
+
+        private:
+            std::array<int, (size_t)PerfEvent::Count> fds;
+            std::array<uint64_t, (size_t)PerfEvent::Count> ids{};
+            int leader = -1;
+            std::string error;
+    };
+
+
+    inline uint64_t PerfSample::operator[](PerfEvent e) const
+    {
+        return values[(size_t)e];
+    }
+
+    inline bool PerfSample::has(PerfEvent e) const
+    {
+        return valid[(size_t)e];
+    }
+
+    inline double PerfSample::ipc() const
+    {
+        if(!has(PerfEvent::Cycles) || !has(PerfEvent::Instructions) || values[(size_t)PerfEvent::Cycles] == 0)
+            return 0.0;
+        return (double)values[(size_t)PerfEvent::Instructions] / values[(size_t)PerfEvent::Cycles];
+    }
+
+    inline PerfSample& PerfSample::operator+=(const PerfSample& other)
+    {
+        for(size_t i = 0; i < values.size(); i++) {
+            values[i] += other.values[i];
+            valid[i] = valid[i] || other.valid[i];
+        }
+        return *this;
+    }
+
+#if defined(__linux__)
+
+    inline PerfCounterGroup::PerfCounterGroup()
+    {
+        fds.fill(-1);
+        const uint64_t configs[] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        int reason = 0;
+        for(size_t i = 0; i < fds.size(); i++)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = leader < 0 ? 1 : 0;     // the leader starts and stops the group
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+            if(fd < 0) {
+                reason = errno;
+                error += std::string(error.empty() ? "" : ", ") + perfEventNames[i] + ": " + std::strerror(reason);
+                continue;
+            }
+
+            fds[i] = fd;
+            if(leader < 0)
+                leader = fd;
+            ioctl(fd, PERF_EVENT_IOC_ID, &ids[i]);
+        }
+
+        // nothing opened: every event failed the same way, say it once
+        if(leader < 0) {
+            error = std::string("perf_event_open: ") + std::strerror(reason);
+            if(reason == EACCES || reason == EPERM)
+                error += " (see /proc/sys/kernel/perf_event_paranoid)";
+            else if(reason == ENOENT || reason == EOPNOTSUPP)
+                error += " (no hardware counters, virtual machine?)";
+        }
+    }
+
+    inline PerfCounterGroup::~PerfCounterGroup()
+    {
+        for(int fd: fds)
+            if(fd >= 0)
+                close(fd);
+    }
+
+    inline void PerfCounterGroup::start()
+    {
+        if(leader < 0)
+            return;
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    inline PerfSample PerfCounterGroup::stop()
+    {
+        PerfSample sample;
+        if(leader < 0)
+            return sample;
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // nr, time enabled, time running, then a value and id per event
+        uint64_t data[3 + 2 * (size_t)PerfEvent::Count] = {};
+        if(read(leader, data, sizeof(data)) <= 0)
+            return sample;
+
+        const uint64_t count = data[0], enabled = data[1], running = data[2];
+        const double scale = running > 0 ? (double)enabled / running : 0.0;
+        for(uint64_t k = 0; k < count && k < (uint64_t)PerfEvent::Count; k++)
+        {
+            const uint64_t value = data[3 + 2 * k], id = data[4 + 2 * k];
+            for(size_t i = 0; i < fds.size(); i++)
+                if(fds[i] >= 0 && ids[i] == id) {
+                    sample.values[i] = static_cast<uint64_t>(value * scale);
+                    sample.valid[i] = running > 0;
+                }
+        }
+        return sample;
+    }
+
+#else
+
+    inline PerfCounterGroup::PerfCounterGroup(): error("perf_event_open needs Linux")
+    {
+        fds.fill(-1);
+    }
+
+    inline PerfCounterGroup::~PerfCounterGroup() { }
+
+    inline void PerfCounterGroup::start() { }
+
+    inline PerfSample PerfCounterGroup::stop()
+    {
+        return {};
+    }
+
+#endif
+
+    inline bool PerfCounterGroup::available() const
+    {
+        return leader >= 0;
+    }
+
+    inline const std::string& PerfCounterGroup::getError() const
+    {
+        return error;
+    }
+
+} // namespace phy
+
+
+#endif
@@ -0,0 +1,311 @@
+/**
+ * Scoped timing zones for the step and render paths.
+ *
+ * PHY_PROFILE_ZONE("name") times the rest of the enclosing scope. Without
+ * PHY_ENABLE_PROFILER the macro expands to nothing, so the zones cost
+ * nothing in normal builds. With it every thread records into its own ring
+ * buffer: the owning thread is the only writer and publishes with a release
+ * store, so recording never takes a lock. Once a ring is full the oldest
+ * zones are overwritten, the rings always hold the most recent history.
+ *
+ * The recorded zones are exported as Chrome trace events (chrome://tracing,
+ * ui.perfetto.dev) or summed per zone name over a recent time window.
+ * Zone names must be string literals, only the pointer is stored.
+ */
+#ifndef __BYTENOL_PCGA_PROFILER_H__
+#define __BYTENOL_PCGA_PROFILER_H__
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+
+#define PHY_PROFILE_CONCAT_(a, b) a##b
+#define PHY_PROFILE_CONCAT(a, b) PHY_PROFILE_CONCAT_(a, b)
+
+#ifdef PHY_ENABLE_PROFILER
+#define PHY_PROFILE_ZONE(name) ::phy::ProfileZone PHY_PROFILE_CONCAT(phyProfileZone, __LINE__)(name)
+#else
+#define PHY_PROFILE_ZONE(name) ((void)0)
+#endif
+
+namespace phy
+{
+    struct ProfileEvent
+    {
+        const char* name;
+        uint64_t start;     // ns since the profiler was created
+        uint64_t end;
+    };
+
+    struct ZoneSummary
+    {
+        const char* name;
+        size_t calls = 0;
+        double totalMs = 0.0;
+        double meanMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    /**
+     * Events of one thread. Written by its thread only, read by anyone:
+     * a reader copies the events below head and then drops those the writer
+     * may have overwritten while it was copying.
+     */
+    class ProfileRing
+    {
+        public:
+            static constexpr size_t capacity = 1 << 14;
+
+            explicit ProfileRing(unsigned int threadIndex);
+
+            void push(const ProfileEvent& e);
+
+            /// @brief Append the events still in the ring to out
+            void copy(std::vector<ProfileEvent>& out) const;
+
+            void clear();
+            unsigned int getThreadIndex() const;
+
+        private:
+            std::array<ProfileEvent, capacity> events;
+            std::atomic<uint64_t> head{ 0 };    // events ever pushed
+            std::atomic<uint64_t> tail{ 0 };    // events before tail were cleared
+            unsigned int threadIndex;
+    };
+
+    class Profiler
+    {
+        public:
+            static Profiler& instance();
+
+            /// @brief Nanoseconds since the profiler was created
+            uint64_t now() const;
+
+            void record(const char* name, uint64_t start, uint64_t end);
+
+            /// @brief Drop every recorded event
+            void clear();
+
+            /// @brief Per zone totals over the last windowMs, most expensive first
+            std::vector<ZoneSummary> summary(double windowMs = 1000.0) const;
+
+            void printSummary(std::ostream& out, double windowMs = 1000.0) const;
+
+            /// @brief Write every recorded event as Chrome trace event JSON
+            bool writeChromeTrace(const std::string& path) const;
+
+        private:
+            Profiler();
+
+            ProfileRing& threadRing();
+
+            using clock = std::chrono::steady_clock;
+            clock::time_point epoch;
+
+            // rings live as long as the profiler so threads may exit at any time
+            mutable std::mutex ringsMutex;
+            std::vector<std::unique_ptr<ProfileRing>> rings;
+    };
+
+    /// @brief Times its own lifetime, made by PHY_PROFILE_ZONE
+    class ProfileZone
+    {
+        public:
+            explicit ProfileZone(const char* name);
+            ~ProfileZone();
+
+            ProfileZone(const ProfileZone&) = delete;
+            ProfileZone& operator=(const ProfileZone&) = delete;
+
+        private:
+            const char* name;
+            uint64_t start;
+    };
+
+
+    inline ProfileRing::ProfileRing(unsigned int index): threadIndex(index) { }
+
+    inline void ProfileRing::push(const ProfileEvent& e)
+    {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        events[h & (capacity - 1)] = e;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    inline void ProfileRing::copy(std::vector<ProfileEvent>& out) const
+    {
+        const uint64_t h = head.load(std::memory_order_acquire);
+        const uint64_t first = std::max(tail.load(std::memory_order_relaxed), h > capacity ? h - capacity : 0);
+        const size_t begin = out.size();
+        for(uint64_t i = first; i < h; i++)
+            out.push_back(events[i & (capacity - 1)]);
+
+        // the writer kept going while we copied, the oldest slots may hold newer
+        // events, the slot of event after - capacity may be half written
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t after = head.load(std::memory_order_relaxed);
+        if(after + 1 > first + capacity) {
+            const size_t stale = std::min<uint64_t>(after + 1 - first - capacity, h - first);
+            out.erase(out.begin() + begin, out.begin() + begin + stale);
+        }
+    }
+
+    inline void ProfileRing::clear()
+    {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+
+    inline unsigned int ProfileRing::getThreadIndex() const
+    {
+        return threadIndex;
+    }
+
+    inline Profiler::Profiler(): epoch(clock::now()) { }
+
+    inline Profiler& Profiler::instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    inline uint64_t Profiler::now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - epoch).count();
+    }
+
+    inline ProfileRing& Profiler::threadRing()
+    {
+        static thread_local ProfileRing* ring = nullptr;
+        if(!ring) {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(std::make_unique<ProfileRing>(static_cast<unsigned int>(rings.size())));
+            ring = rings.back().get();
+        }
+        return *ring;
+    }
+
+    inline void Profiler::record(const char* name, uint64_t start, uint64_t end)
+    {
+        threadRing().push({ name, start, end });
+    }
+
+    inline void Profiler::clear()
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for(auto& r: rings)
+            r->clear();
+    }
+
+    inline std::vector<ZoneSummary> Profiler::summary(double windowMs) const
+    {
+        std::vector<ProfileEvent> events;
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for(const auto& r: rings)
+                r->copy(events);
+        }
+
+        const uint64_t window = static_cast<uint64_t>(windowMs * 1e6);
+        const uint64_t t = now();
+        const uint64_t since = t > window ? t - window : 0;
+
+        // the same literal may have several addresses across translation units
+        std::vector<ZoneSummary> zones;
+        for(const auto& e: events)
+        {
+            if(e.end < since)
+                continue;
+
+            auto it = std::find_if(zones.begin(), zones.end(), [&](const ZoneSummary& z) {
+                return z.name == e.name || std::strcmp(z.name, e.name) == 0;
+            });
+            if(it == zones.end()) {
+                zones.push_back({ e.name });
+                it = zones.end() - 1;
+            }
+
+            double ms = (e.end - e.start) * 1e-6;
+            it->calls++;
+            it->totalMs += ms;
+            it->maxMs = std::max(it->maxMs, ms);
+        }
+
+        for(auto& z: zones)
+            z.meanMs = z.totalMs / z.calls;
+        std::sort(zones.begin(), zones.end(), [](const ZoneSummary& a, const ZoneSummary& b) {
+            return a.totalMs > b.totalMs;
+        });
+        return zones;
+    }
+
+    inline void Profiler::printSummary(std::ostream& out, double windowMs) const
+    {
+        out << std::left << std::setw(28) << "zone" << std::right << std::setw(10) << "calls"
+            << std::setw(12) << "total ms" << std::setw(12) << "mean ms" << std::setw(12) << "max ms" << "\n";
+        for(const auto& z: summary(windowMs))
+            out << std::left << std::setw(28) << z.name << std::right << std::setw(10) << z.calls
+                << std::fixed << std::setprecision(4) << std::setw(12) << z.totalMs
+                << std::setw(12) << z.meanMs << std::setw(12) << z.maxMs << "\n";
+    }
+
+    inline bool Profiler::writeChromeTrace(const std::string& path) const
+    {
+        std::ofstream file(path);
+        if(!file)
+            return false;
+
+        std::vector<ProfileEvent> events;
+        std::vector<std::pair<unsigned int, size_t>> ranges;    // thread index, end of its events
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for(const auto& r: rings) {
+                r->copy(events);
+                ranges.push_back({ r->getThreadIndex(), events.size() });
+            }
+        }
+
+        // complete events ("ph": "X") in microseconds
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        bool first = true;
+        size_t begin = 0;
+        for(const auto& [thread, end]: ranges)
+        {
+            file << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+                << thread << ", \"args\": {\"name\": \"thread " << thread << "\"}}";
+            first = false;
+
+            for(size_t i = begin; i < end; i++)
+            {
+                const auto& e = events[i];
+                file << ",\n{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread
+                    << std::fixed << std::setprecision(3) << ", \"ts\": " << e.start * 1e-3
+                    << ", \"dur\": " << (e.end - e.start) * 1e-3 << "}";
+            }
+            begin = end;
+        }
+        file << "\n]}\n";
+        return static_cast<bool>(file);
+    }
+
+    inline ProfileZone::ProfileZone(const char* n): name(n), start(Profiler::instance().now()) { }
+
+    inline ProfileZone::~ProfileZone()
+    {
+        Profiler& p = Profiler::instance();
+        p.record(name, start, p.now());
+    }
+
+} // namespace phy
+
+
+#endif
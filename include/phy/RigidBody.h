@@ -15,15 +15,26 @@ namespace phy
     class RigidBody
     {
         public:
-            float mass = 1.0f;
+            float mass = 1.0f;      // 0 for static bodies
             float im = 5000.0f;    // moment of inertia
             float angVel = 0.0f;    // angular velocity
             float rotation = 0.0f;
+            bool isBullet = false;  // fast body, see TimeOfImpact.h
+            unsigned int category = 1;          // collision layers the body belongs to
+            unsigned int mask = 0xffffffff;     // collision layers the body collides with
+            float radius = 0.0f;    // circle radius, bodies without vertices are circles
+            float charge = 0.0f;    // only used by scenarios with electric forces
+
+            bool awake = true;
+            int sleepCounter = 0;   // consecutive steps spent below the sleep threshold
             
             Vector2 pos;
             Vector2 vel;
             vertices_t vertices;
 
+            // transformed vertex data: updated every step while the body is awake
+            vertices_t transformed;
+
             struct color { 
                 unsigned short r = 255;
                 unsigned short g = 0;
@@ -32,6 +43,10 @@ namespace phy
 
             RigidBody() = default;
             explicit RigidBody(const vertices_t& v);
+
+            bool isStatic() const;
+            float invMass() const;
+            float invInertia() const;
     };
 
 
@@ -41,6 +56,21 @@ namespace phy
         vertices.insert(vertices.end(), v.begin(), v.end());
     }
 
+    inline bool RigidBody::isStatic() const
+    {
+        return mass <= 0.0f;
+    }
+
+    inline float RigidBody::invMass() const
+    {
+        return isStatic() ? 0.0f : 1.0f / mass;
+    }
+
+    inline float RigidBody::invInertia() const
+    {
+        return isStatic() || im <= 0.0f ? 0.0f : 1.0f / im;
+    }
+
 } // namespace phy
 
 
@@ -0,0 +1,99 @@
+/**
+ * Reference separating axis test of the SAT_test demo and the polygon
+ * generator it uses. Kept deliberately plain: benchmarks measure the
+ * optimized kernels against it and differential tests compare their
+ * answers with it.
+ */
+#ifndef __BYTENOL_PCGA_SAT_H__
+#define __BYTENOL_PCGA_SAT_H__
+
+#include <span>
+#include <cmath>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "Vector.h"
+
+namespace phy
+{
+    /// @brief Carry out the seperating axis theorem on two convex polygons
+    /// @param a world space vertices of the first polygon
+    /// @param b world space vertices of the second polygon
+    /// @return true if there is any collision, touching included
+    bool satCollision(std::span<const Vector2> a, std::span<const Vector2> b);
+
+    /// @brief Vertices of the polygons of SAT_test: one every 360 / sides degrees
+    std::vector<Vector2> polarPolygon(int sides, float radius);
+
+    /// @brief Random polygon as made by SAT_test, from a caller seeded engine
+    /// @param sides receives the number of sides, 3 to 6
+    /// @param radius receives the radius, 5 to 50
+    std::vector<Vector2> randomPolygon(std::mt19937& eng, int& sides, float& radius);
+
+
+    inline bool satCollision(std::span<const Vector2> a, std::span<const Vector2> b)
+    {
+        const std::span<const Vector2>* poly1 = &a;
+        const std::span<const Vector2>* poly2 = &b;
+
+        for(int i = 0; i < 2; i++)
+        {
+            if(i > 0) {
+                poly1 = &b;
+                poly2 = &a;
+            }
+
+            for(size_t j = 0; j < poly1->size(); j++)
+            {
+                auto p1 = (*poly1)[j];
+                auto p2 = (*poly1)[(j + 1) % poly1->size()];
+                auto vDir = p2 - p1;
+                auto normal = Vector2{ vDir.y, -vDir.x }.normalize();
+
+                float min_1 = INFINITY, max_1 = -INFINITY;
+                for(const auto& v: *poly1)
+                {
+                    float dp = v.dotProduct(normal);
+                    min_1 = std::min(min_1, dp);
+                    max_1 = std::max(max_1, dp);
+                }
+
+                float min_2 = INFINITY, max_2 = -INFINITY;
+                for(const auto& v: *poly2)
+                {
+                    float dp = v.dotProduct(normal);
+                    min_2 = std::min(min_2, dp);
+                    max_2 = std::max(max_2, dp);
+                }
+
+                if(!(min_1 <= max_2 && min_2 <= max_1))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    inline std::vector<Vector2> polarPolygon(int sides, float radius)
+    {
+        int step = 360 / sides;
+        std::vector<Vector2> vertices;
+        for(int j = 0; j < 360; j += step)
+        {
+            float angle = j * 3.14159f / 180;
+            vertices.push_back({ std::cos(angle) * radius, std::sin(angle) * radius });
+        }
+        return vertices;
+    }
+
+    inline std::vector<Vector2> randomPolygon(std::mt19937& eng, int& sides, float& radius)
+    {
+        sides = std::uniform_int_distribution<>(3, 6)(eng);
+        radius = std::uniform_int_distribution<>(5, 50)(eng);
+        return polarPolygon(sides, radius);
+    }
+
+} // namespace phy
+
+
+#endif
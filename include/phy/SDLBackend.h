@@ -0,0 +1,314 @@
+/**
+ * SDL2 consumer of a DrawList. This is the only phy header that includes
+ * SDL: the physics types record commands and this backend turns each run of
+ * equal primitive, color and alpha into one SDL submission.
+ */
+#ifndef __BYTENOL_PCGA_SDL_BACKEND_H__
+#define __BYTENOL_PCGA_SDL_BACKEND_H__
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <SDL.h>
+#include "DrawList.h"
+#include "Profiler.h"
+
+namespace phy {
+
+    /// @brief Pre-rasterized circle textures keyed by radius, color, alpha and style.
+    /// A cached circle is drawn with a single SDL_RenderCopy.
+    class CircleTextureCache
+    {
+        public:
+            SDL_Texture* get(SDL_Renderer* renderer, int radius, unsigned int color, Uint8 alpha, bool stroked);
+            void clear();
+            ~CircleTextureCache();
+
+        private:
+            std::unordered_map<uint64_t, SDL_Texture*> textures;
+    };
+
+    class SDLBackend
+    {
+        public:
+            explicit SDLBackend(SDL_Renderer* renderer);
+
+            /// @brief optional, when set circles are drawn from cached textures
+            void setTextureCache(CircleTextureCache* cache);
+
+            /// @brief Draw every command of the list, in order
+            void submit(const DrawList& list);
+
+            /// @brief Half width of every scanline of a filled circle, from the top row to the bottom one
+            static void filledSpans(int radius, std::vector<int>& halfWidths);
+
+            /// @brief Offsets of the pixels on the outline of a circle
+            static void strokedPoints(int radius, std::vector<SDL_Point>& points);
+
+        private:
+            void setColor(const DrawCommand& c);
+            void drawCircles(const DrawCommand* first, const DrawCommand* last);
+            void drawOutlines(const DrawCommand* first, const DrawCommand* last);
+            void drawLines(const DrawCommand* first, const DrawCommand* last);
+            void drawPolygons(const DrawCommand* first, const DrawCommand* last, const std::vector<Vector2>& vertices);
+            void drawCached(const DrawCommand* first, const DrawCommand* last, bool stroked);
+
+            SDL_Renderer* renderer;
+            CircleTextureCache* textureCache = nullptr;
+
+            // scratch storage reused by every submit
+            std::vector<int> halfWidths;
+            std::vector<SDL_Rect> spans;
+            std::vector<SDL_Point> outline;
+            std::vector<SDL_Point> points;
+            std::vector<SDL_Color> colors;
+            std::vector<int> indices;
+    };
+
+
+    inline SDLBackend::SDLBackend(SDL_Renderer* renderer): renderer(renderer) {}
+
+    inline void SDLBackend::setTextureCache(CircleTextureCache* cache)
+    {
+        textureCache = cache;
+    }
+
+    inline void SDLBackend::submit(const DrawList& list)
+    {
+        PHY_PROFILE_ZONE("SDLBackend::submit");
+        const auto& commands = list.getCommands();
+        const DrawCommand* c = commands.data();
+        const DrawCommand* end = c + commands.size();
+
+        while(c != end)
+        {
+            // a run shares the primitive, the color and the alpha, polygons carry
+            // their color per vertex so a run of them only ends at another primitive
+            const DrawCommand* last = c + 1;
+            while(last != end && last->type == c->type &&
+                (c->type == DrawPrimitive::Polygon || (last->color == c->color && last->alpha8() == c->alpha8())))
+                last++;
+
+            switch(c->type)
+            {
+                case DrawPrimitive::Circle:
+                    textureCache ? drawCached(c, last, false) : drawCircles(c, last);
+                    break;
+                case DrawPrimitive::CircleOutline:
+                    textureCache ? drawCached(c, last, true) : drawOutlines(c, last);
+                    break;
+                case DrawPrimitive::Line: drawLines(c, last); break;
+                case DrawPrimitive::Polygon: drawPolygons(c, last, list.getVertices()); break;
+                default: break;
+            }
+            c = last;
+        }
+    }
+
+    inline void SDLBackend::setColor(const DrawCommand& c)
+    {
+        SDL_SetRenderDrawColor(renderer, (c.color >> 16) & 255, (c.color >> 8) & 255, c.color & 255, c.alpha8());
+    }
+
+    inline void SDLBackend::drawCircles(const DrawCommand* first, const DrawCommand* last)
+    {
+        // one rect per scanline, the whole run submitted together
+        spans.clear();
+        for(auto c = first; c != last; c++)
+        {
+            const int radius = static_cast<int>(std::lround(c->x2));
+            filledSpans(radius, halfWidths);
+            const int cx = static_cast<int>(c->x1);
+            const int cy = static_cast<int>(c->y1);
+            for(int row = -radius; row <= radius; row++) {
+                int half = halfWidths[row + radius];
+                spans.push_back({ cx - half, cy + row, 2 * half + 1, 1 });
+            }
+        }
+        setColor(*first);
+        SDL_RenderFillRects(renderer, spans.data(), static_cast<int>(spans.size()));
+    }
+
+    inline void SDLBackend::drawOutlines(const DrawCommand* first, const DrawCommand* last)
+    {
+        points.clear();
+        for(auto c = first; c != last; c++)
+        {
+            strokedPoints(static_cast<int>(std::lround(c->x2)), outline);
+            const int cx = static_cast<int>(c->x1);
+            const int cy = static_cast<int>(c->y1);
+            for(const auto& p: outline)
+                points.push_back({ p.x + cx, p.y + cy });
+        }
+        setColor(*first);
+        SDL_RenderDrawPoints(renderer, points.data(), static_cast<int>(points.size()));
+    }
+
+    inline void SDLBackend::drawLines(const DrawCommand* first, const DrawCommand* last)
+    {
+        // SDL2 only batches connected lines, the color is still set once per run
+        setColor(*first);
+        for(auto c = first; c != last; c++)
+            SDL_RenderDrawLineF(renderer, c->x1, c->y1, c->x2, c->y2);
+    }
+
+    inline void SDLBackend::drawPolygons(const DrawCommand* first, const DrawCommand* last, const std::vector<Vector2>& vertices)
+    {
+        // the positions are read in place from the range of the list the run uses,
+        // only the colors of that range are written
+        uint32_t lo = first->first, hi = first->first + first->count;
+        for(auto c = first; c != last; c++) {
+            lo = std::min(lo, c->first);
+            hi = std::max(hi, c->first + c->count);
+        }
+
+        colors.assign(hi - lo, SDL_Color{ 0, 0, 0, 0 });
+        indices.clear();
+        for(auto c = first; c != last; c++)
+        {
+            const int base = static_cast<int>(c->first - lo);
+            const SDL_Color color{ (Uint8)((c->color >> 16) & 255), (Uint8)((c->color >> 8) & 255),
+                (Uint8)(c->color & 255), c->alpha8() };
+            std::fill_n(colors.begin() + base, c->count, color);
+            for(uint32_t k = 1; k + 1 < c->count; k++) {
+                indices.push_back(base);
+                indices.push_back(base + k);
+                indices.push_back(base + k + 1);
+            }
+        }
+
+        SDL_RenderGeometryRaw(renderer, nullptr,
+            &vertices[lo].x, sizeof(Vector2),
+            colors.data(), sizeof(SDL_Color),
+            nullptr, 0, static_cast<int>(hi - lo),
+            indices.data(), static_cast<int>(indices.size()), sizeof(int));
+    }
+
+    inline void SDLBackend::drawCached(const DrawCommand* first, const DrawCommand* last, bool stroked)
+    {
+        for(auto c = first; c != last; c++)
+        {
+            const int radius = static_cast<int>(std::lround(c->x2));
+            SDL_Texture* texture = textureCache->get(renderer, radius, c->color, c->alpha8(), stroked);
+            if(!texture) continue;
+            SDL_Rect dst{ static_cast<int>(c->x1) - radius, static_cast<int>(c->y1) - radius, 2 * radius + 1, 2 * radius + 1 };
+            SDL_RenderCopy(renderer, texture, nullptr, &dst);
+        }
+    }
+
+
+    inline void SDLBackend::filledSpans(int radius, std::vector<int>& halfWidths)
+    {
+        halfWidths.assign(2 * radius + 1, 0);
+        auto widen = [&](int row, int half) {
+            halfWidths[row + radius] = std::max(halfWidths[row + radius], half);
+        };
+
+        int x = 0;
+        int y = radius;
+        int d = 3 - 2 * radius;
+
+        while (y >= x) {
+            // the 4 scanlines touched by this step of the circle
+            widen(-y, x);
+            widen(y, x);
+            widen(-x, y);
+            widen(x, y);
+
+            // Update decision parameter and points
+            if (d < 0) {
+                d = d + 4 * x + 6;
+            } else {
+                d = d + 4 * (x - y) + 10;
+                y--;
+            }
+            x++;
+        }
+    }
+
+
+    inline void SDLBackend::strokedPoints(int radius, std::vector<SDL_Point>& points)
+    {
+        points.clear();
+        int x = 0;
+        int y = radius;
+        int d = 3 - 2 * radius;
+
+        while (y >= x) {
+            // the 8 symmetrical points of the circle
+            points.push_back({ x, y });
+            points.push_back({ -x, y });
+            points.push_back({ x, -y });
+            points.push_back({ -x, -y });
+            points.push_back({ y, x });
+            points.push_back({ -y, x });
+            points.push_back({ y, -x });
+            points.push_back({ -y, -x });
+
+            // Update the decision parameter and points
+            if (d < 0) {
+                d = d + 4 * x + 6;
+            } else {
+                d = d + 4 * (x - y) + 10;
+                y--;
+            }
+            x++;
+        }
+    }
+
+
+    inline SDL_Texture* CircleTextureCache::get(SDL_Renderer* renderer, int radius, unsigned int color, Uint8 alpha, bool stroked)
+    {
+        const uint64_t key = (static_cast<uint64_t>(radius) << 33) | (static_cast<uint64_t>(stroked) << 32) |
+            ((color & 0xffffff) << 8) | alpha;
+        auto it = textures.find(key);
+        if(it != textures.end())
+            return it->second;
+
+        // rasterize with the same spans / points as the direct path
+        const int size = 2 * radius + 1;
+        const uint32_t pixel = (static_cast<uint32_t>(alpha) << 24) | (color & 0xffffff);
+        std::vector<uint32_t> pixels(size * size, 0);
+        if(stroked) {
+            std::vector<SDL_Point> points;
+            SDLBackend::strokedPoints(radius, points);
+            for(const auto& p: points)
+                pixels[(p.y + radius) * size + p.x + radius] = pixel;
+        } else {
+            std::vector<int> halfWidths;
+            SDLBackend::filledSpans(radius, halfWidths);
+            for(int row = 0; row < size; row++)
+                for(int x = radius - halfWidths[row]; x <= radius + halfWidths[row]; x++)
+                    pixels[row * size + x] = pixel;
+        }
+
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, size, size);
+        if(!texture) {
+            std::cerr << "SDL failed to create circle texture" << std::endl;
+            return nullptr;
+        }
+        SDL_UpdateTexture(texture, nullptr, pixels.data(), size * sizeof(uint32_t));
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        textures[key] = texture;
+        return texture;
+    }
+
+
+    inline void CircleTextureCache::clear()
+    {
+        for(auto& [key, texture]: textures)
+            SDL_DestroyTexture(texture);
+        textures.clear();
+    }
+
+
+    inline CircleTextureCache::~CircleTextureCache()
+    {
+        clear();
+    }
+}
+
+#endif
@@ -0,0 +1,402 @@
+/**
+ * Repeatable macro workloads for the World. A scenario builds a world from
+ * a body count and a seed, and may apply its own forces before every step.
+ * They are listed in a table so runners can pick one by name, every
+ * scenario is deterministic for a given seed.
+ */
+#ifndef __BYTENOL_PCGA_SCENARIO_H__
+#define __BYTENOL_PCGA_SCENARIO_H__
+
+#include <cmath>
+#include <vector>
+#include <random>
+#include <string>
+#include <algorithm>
+#include "Vector.h"
+#include "RigidBody.h"
+#include "World.h"
+#include "SAT.h"
+
+namespace phy
+{
+    struct ScenarioParams
+    {
+        int bodies = 500;       // dynamic bodies, static walls come on top
+        unsigned int seed = 1;
+    };
+
+    using ScenarioBuildFn = void (*)(World& world, const ScenarioParams& params);
+    using ScenarioForceFn = void (*)(World& world, float dt);
+
+    struct Scenario
+    {
+        const char* name;
+        const char* description;
+        ScenarioBuildFn build;
+        ScenarioForceFn applyForces;    // nullptr when gravity is all there is
+    };
+
+    void polygonRain(World& world, const ScenarioParams& params);
+    void ballPit(World& world, const ScenarioParams& params);
+    void pyramid(World& world, const ScenarioParams& params);
+    void wallMaze(World& world, const ScenarioParams& params);
+    void chargedCloud(World& world, const ScenarioParams& params);
+    void bulletRange(World& world, const ScenarioParams& params);
+    void fastBalls(World& world, const ScenarioParams& params);
+
+    /// @brief Pairwise Coulomb forces between every charged body, O(n^2)
+    void coulombForces(World& world, float dt);
+
+    inline constexpr Scenario scenarios[] = {
+        { "rain", "random SAT_test polygons falling into a container", polygonRain, nullptr },
+        { "ballpit", "balls packed into a container", ballPit, nullptr },
+        { "pyramid", "a pyramid of boxes resting on the floor", pyramid, nullptr },
+        { "maze", "balls bouncing through a maze of static walls", wallMaze, nullptr },
+        { "charged", "a cloud of charged particles without gravity", chargedCloud, coulombForces },
+        { "bullets", "fast bullet balls and boxes between thin walls and posts", bulletRange, nullptr },
+        { "fastballs", "fast balls, not bullets, between thin walls and posts", fastBalls, nullptr },
+    };
+
+    /// @return the scenario called name, nullptr if there is none
+    const Scenario* findScenario(const std::string& name);
+
+    /// @brief Apply the scenario forces and step the world
+    void stepScenario(const Scenario& scenario, World& world, float dt);
+
+    /// @brief Axis aligned box centered on the origin
+    vertices_t boxVertices(float w, float h);
+
+    /// @brief Static box, used for floors and walls
+    void addStaticBox(World& world, float x, float y, float w, float h);
+
+    /// @brief Static floor and side walls around a box of the given size
+    void addContainer(World& world, float width, float height);
+
+    /// @brief Elastic world without gravity inside 4 unit walls 800 units wide, with
+    /// a column of posts down the middle, for rows rows of shots 24 units apart
+    void addShootingRange(World& world, int rows);
+
+
+    inline const Scenario* findScenario(const std::string& name)
+    {
+        for(const auto& s: scenarios)
+            if(name == s.name)
+                return &s;
+        return nullptr;
+    }
+
+    inline void stepScenario(const Scenario& scenario, World& world, float dt)
+    {
+        if(scenario.applyForces)
+            scenario.applyForces(world, dt);
+        world.step(dt);
+    }
+
+    inline vertices_t boxVertices(float w, float h)
+    {
+        return { { -w / 2, -h / 2 }, { w / 2, -h / 2 }, { w / 2, h / 2 }, { -w / 2, h / 2 } };
+    }
+
+    inline void addStaticBox(World& world, float x, float y, float w, float h)
+    {
+        RigidBody wall(boxVertices(w, h));
+        wall.pos = { x, y };
+        wall.mass = 0.0f;
+        wall.color = { 80, 80, 80 };
+        world.add(wall);
+    }
+
+    inline void addContainer(World& world, float width, float height)
+    {
+        const float t = 20.0f;  // wall thickness
+        addStaticBox(world, width / 2, height + t / 2, width + 2 * t, t);
+        addStaticBox(world, -t / 2, height / 2, t, height);
+        addStaticBox(world, width + t / 2, height / 2, t, height);
+    }
+
+    inline void addShootingRange(World& world, int rows)
+    {
+        const float spacing = 24.0f, width = 800.0f, height = rows * spacing + 40.0f, t = 4.0f;
+        world.gravity = { 0.0f, 0.0f };
+        world.restitution = 1.0f;
+        world.restitutionThreshold = 0.0f;
+        world.friction = 0.0f;
+        world.allowSleep = false;
+
+        addStaticBox(world, 0.0f, height / 2, t, height + t);
+        addStaticBox(world, width, height / 2, t, height + t);
+        addStaticBox(world, width / 2, 0.0f, width + t, t);
+        addStaticBox(world, width / 2, height, width + t, t);
+        for(int i = 0; i < rows; i++)
+        {
+            RigidBody post;
+            post.radius = 6.0f;
+            post.pos = { width / 2 + (i % 2 ? 60.0f : -60.0f), 20.0f + (i + 0.5f) * spacing };
+            post.mass = 0.0f;
+            post.color = { 80, 80, 80 };
+            world.add(post);
+        }
+    }
+
+    inline void polygonRain(World& world, const ScenarioParams& params)
+    {
+        std::mt19937 eng(params.seed);
+        std::uniform_real_distribution<float> jitter(-8.0f, 8.0f);
+        std::uniform_real_distribution<float> fall(0.0f, 150.0f);
+
+        // polygons go up to a radius of 50, one per cell in rows above the floor
+        const float cell = 110.0f;
+        const int columns = std::max(1, (int)std::sqrt(params.bodies * 2.0f));
+        const float width = columns * cell, height = 800.0f;
+        world.gravity = { 0.0f, 400.0f };
+        addContainer(world, width, height);
+
+        for(int i = 0; i < params.bodies; i++)
+        {
+            int sides;
+            float radius;
+            RigidBody body(randomPolygon(eng, sides, radius));
+            body.pos = { (i % columns + 0.5f) * cell + jitter(eng), height - (i / columns + 0.5f) * cell };
+            body.vel = { 0.0f, fall(eng) };
+            body.rotation = static_cast<float>(eng() % 360);
+            body.mass = radius * radius * 0.01f;
+            body.im = body.mass * radius * radius * 0.5f;
+            body.color = { 255, 0, 255 };
+            world.add(body);
+        }
+    }
+
+    inline void ballPit(World& world, const ScenarioParams& params)
+    {
+        std::mt19937 eng(params.seed);
+        std::uniform_real_distribution<float> radius(6.0f, 10.0f);
+
+        // hexagonal packing, already touching so contacts start on the first step
+        const float cell = 20.0f;
+        const int columns = std::max(1, (int)std::sqrt(params.bodies * 2.0f));
+        const float width = columns * cell + cell * 0.5f;
+        const float height = std::max(400.0f, (params.bodies / columns + 2) * cell * 0.87f);
+        world.gravity = { 0.0f, 400.0f };
+        addContainer(world, width, height);
+
+        for(int i = 0; i < params.bodies; i++)
+        {
+            const int row = i / columns;
+            RigidBody body;
+            body.radius = radius(eng);
+            body.pos = { (i % columns + 0.5f + (row % 2) * 0.5f) * cell, height - (row + 0.5f) * cell * 0.87f };
+            body.mass = body.radius * body.radius * 0.01f;
+            body.im = body.mass * body.radius * body.radius * 0.5f;
+            body.color = { 0, 128, 255 };
+            world.add(body);
+        }
+    }
+
+    inline void pyramid(World& world, const ScenarioParams& params)
+    {
+        // the largest pyramid with at most params.bodies boxes
+        int rows = 1;
+        while((rows + 1) * (rows + 2) / 2 <= params.bodies)
+            rows++;
+
+        const float size = 20.0f;
+        const float width = (rows + 2) * size, height = 600.0f;
+        world.gravity = { 0.0f, 400.0f };
+        addContainer(world, width, height);
+
+        const auto box = boxVertices(size, size);
+        for(int row = 0; row < rows; row++)
+        {
+            for(int i = 0; i < rows - row; i++)
+            {
+                RigidBody body(box);
+                body.pos = { size * (1.5f + i + row * 0.5f), height - size * (row + 0.5f) };
+                body.mass = 1.0f;
+                body.im = body.mass * size * size / 6.0f;
+                body.color = { 255, 160, 0 };
+                world.add(body);
+            }
+        }
+    }
+
+    inline void wallMaze(World& world, const ScenarioParams& params)
+    {
+        std::mt19937 eng(params.seed);
+
+        // a perfect maze carved by a depth first walk, about 2 balls per cell
+        const int cells = std::max(2, (int)std::sqrt(params.bodies * 0.5f));
+        const float cell = 60.0f, t = 6.0f;
+        std::vector<char> visited(cells * cells, 0);
+        std::vector<char> openRight(cells * cells, 0), openDown(cells * cells, 0);
+        std::vector<int> stack{ 0 };
+        visited[0] = 1;
+        while(!stack.empty())
+        {
+            int c = stack.back();
+            int x = c % cells, y = c / cells;
+            int options[4], n = 0;
+            if(x > 0 && !visited[c - 1]) options[n++] = c - 1;
+            if(x + 1 < cells && !visited[c + 1]) options[n++] = c + 1;
+            if(y > 0 && !visited[c - cells]) options[n++] = c - cells;
+            if(y + 1 < cells && !visited[c + cells]) options[n++] = c + cells;
+            if(n == 0) {
+                stack.pop_back();
+                continue;
+            }
+            int next = options[eng() % n];
+            if(next == c + 1) openRight[c] = 1;
+            else if(next == c - 1) openRight[next] = 1;
+            else if(next == c + cells) openDown[c] = 1;
+            else openDown[next] = 1;
+            visited[next] = 1;
+            stack.push_back(next);
+        }
+
+        world.gravity = { 0.0f, 0.0f };
+        world.restitution = 0.9f;
+        world.restitutionThreshold = 0.0f;
+        world.friction = 0.0f;
+        world.allowSleep = false;
+
+        const float size = cells * cell;
+        addStaticBox(world, size / 2, 0.0f, size + t, t);
+        addStaticBox(world, 0.0f, size / 2, t, size + t);
+        for(int y = 0; y < cells; y++)
+            for(int x = 0; x < cells; x++)
+            {
+                int c = y * cells + x;
+                if(!openRight[c]) addStaticBox(world, (x + 1) * cell, (y + 0.5f) * cell, t, cell + t);
+                if(!openDown[c]) addStaticBox(world, (x + 0.5f) * cell, (y + 1) * cell, cell + t, t);
+            }
+
+        std::uniform_real_distribution<float> offset(-15.0f, 15.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 2 * 3.14159f);
+        for(int i = 0; i < params.bodies; i++)
+        {
+            int c = i % (cells * cells);
+            float a = angle(eng);
+            RigidBody body;
+            body.radius = 5.0f;
+            body.pos = { (c % cells + 0.5f) * cell + offset(eng), (c / cells + 0.5f) * cell + offset(eng) };
+            body.vel = { std::cos(a) * 150.0f, std::sin(a) * 150.0f };
+            body.mass = 0.25f;
+            body.im = body.mass * body.radius * body.radius * 0.5f;
+            body.color = { 0, 200, 100 };
+            world.add(body);
+        }
+    }
+
+    inline void chargedCloud(World& world, const ScenarioParams& params)
+    {
+        std::mt19937 eng(params.seed);
+        const float extent = std::sqrt((float)params.bodies) * 30.0f;
+        std::uniform_real_distribution<float> radius(0.0f, extent);
+        std::uniform_real_distribution<float> angle(0.0f, 2 * 3.14159f);
+
+        world.gravity = { 0.0f, 0.0f };
+        world.allowSleep = false;
+
+        for(int i = 0; i < params.bodies; i++)
+        {
+            // uniform over the disk
+            float r = extent * std::sqrt(radius(eng) / extent), a = angle(eng);
+            RigidBody body;
+            body.radius = 3.0f;
+            body.pos = { extent + std::cos(a) * r, extent + std::sin(a) * r };
+            body.mass = 1.0f;
+            body.im = body.mass * body.radius * body.radius * 0.5f;
+            body.charge = (eng() & 1) ? 1.0f : -1.0f;
+            if(body.charge > 0.0f) body.color = { 255, 60, 60 };
+            else body.color = { 60, 60, 255 };
+            world.add(body);
+        }
+    }
+
+    inline void bulletRange(World& world, const ScenarioParams& params)
+    {
+        std::mt19937 eng(params.seed);
+        std::uniform_real_distribution<float> speed(2500.0f, 4000.0f);
+        std::uniform_real_distribution<float> slope(-0.2f, 0.2f);
+
+        // bullets cross several times the 4 unit walls and the posts every step,
+        // only the time of impact keeps them between the walls
+        const float spacing = 24.0f;
+        addShootingRange(world, std::max(1, params.bodies / 4));
+
+        const auto box = boxVertices(6.0f, 6.0f);
+        for(int i = 0; i < params.bodies; i++)
+        {
+            RigidBody body;
+            if(i % 2)
+                body = RigidBody(box);
+            else
+                body.radius = 3.0f;
+            body.isBullet = true;
+            body.pos = { 40.0f + (i % 4) * 30.0f, 20.0f + (i / 4 + 0.5f) * spacing };
+            const float v = speed(eng);
+            body.vel = { v, v * slope(eng) };
+            body.mass = 0.1f;
+            body.im = body.mass * 9.0f;
+            body.color = { 255, 220, 0 };
+            world.add(body);
+        }
+    }
+
+    inline void fastBalls(World& world, const ScenarioParams& params)
+    {
+        std::mt19937 eng(params.seed);
+        std::uniform_real_distribution<float> speed(1500.0f, 3000.0f);
+        std::uniform_real_distribution<float> slope(-0.5f, 0.5f);
+
+        // the balls move 8 to 17 radii a step, they stay between the walls only
+        // because World sweeps them against the static bodies
+        const float spacing = 24.0f;
+        addShootingRange(world, std::max(1, params.bodies / 4));
+
+        for(int i = 0; i < params.bodies; i++)
+        {
+            RigidBody body;
+            body.radius = 3.0f;
+            body.pos = { 40.0f + (i % 4) * 30.0f, 20.0f + (i / 4 + 0.5f) * spacing };
+            const float v = speed(eng);
+            body.vel = { v, v * slope(eng) };
+            body.mass = 0.1f;
+            body.im = body.mass * 9.0f;
+            body.color = { 0, 220, 120 };
+            world.add(body);
+        }
+    }
+
+    inline void coulombForces(World& world, float dt)
+    {
+        const float k = 2000.0f;        // force constant
+        const float softening = 25.0f;  // keeps the force finite when bodies touch
+
+        auto& bodies = world.bodies;
+        for(size_t i = 0; i < bodies.size(); i++)
+        {
+            auto& a = bodies[i];
+            if(a.charge == 0.0f || a.isStatic())
+                continue;
+
+            for(size_t j = i + 1; j < bodies.size(); j++)
+            {
+                auto& b = bodies[j];
+                if(b.charge == 0.0f || b.isStatic())
+                    continue;
+
+                Vector2 d = b.pos - a.pos;
+                float r2 = d.dotProduct(d) + softening;
+                Vector2 f = d * (k * a.charge * b.charge / (r2 * std::sqrt(r2)));
+
+                // like charges push apart, opposite ones pull together
+                a.vel -= f * (a.invMass() * dt);
+                b.vel += f * (b.invMass() * dt);
+            }
+        }
+    }
+
+} // namespace phy
+
+
+#endif
@@ -0,0 +1,532 @@
+/**
+ * Headless renderer drawing into a CPU framebuffer. Commands are recorded
+ * like the Canvas2d batches, binned into screen tiles on flush and every
+ * tile is rasterized by whichever worker thread picks it up first. Tiles
+ * never share pixels, so the workers need no locking and each tile keeps
+ * the submission order of its commands. Given a JobSystem the tiles are
+ * jobs on its threads, otherwise flush starts its own workers.
+ */
+#ifndef __BYTENOL_PCGA_SOFTWARE_RENDERER_H__
+#define __BYTENOL_PCGA_SOFTWARE_RENDERER_H__
+
+#include <array>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include "Vector.h"
+#include "DrawList.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace phy
+{
+    struct RasterStats
+    {
+        size_t commands = 0;        // commands recorded since the last flush
+        size_t binnedCommands = 0;  // sum over every tile of the commands it rasterized
+        size_t tiles = 0;
+        unsigned int threads = 0;
+    };
+
+    class SoftwareRenderer
+    {
+        public:
+            /// @param threads worker threads used by flush, 0 picks std::thread::hardware_concurrency
+            SoftwareRenderer(int width, int height, int tileSize = 64, unsigned int threads = 0);
+
+            void setThreads(unsigned int threads);
+
+            /// @brief Rasterize the tiles as jobs of jobs, which replaces the thread count,
+            /// nullptr goes back to threads started by flush
+            void setJobSystem(JobSystem* jobs);
+
+            /// @brief Fill the whole framebuffer, pending commands are dropped
+            void clear(unsigned int hex);
+
+            void fillCircle(float x, float y, float radius, unsigned int hex, float alpha = 1.0f);
+            void drawLine(float x1, float y1, float x2, float y2, unsigned int hex, float alpha = 1.0f);
+
+            /// @brief Fill any simple polygon with the even-odd rule, the vertices are copied
+            void fillPolygon(const Vector2* vertices, size_t count, unsigned int hex, float alpha = 1.0f);
+
+            /// @brief Record every command of a DrawList, outlines become line segments
+            void submit(const DrawList& list);
+
+            /// @brief Rasterize every pending command into the framebuffer
+            void flush();
+
+            /// @brief Binary PPM (P6) of the framebuffer
+            /// @return false if the file could not be written
+            bool writePPM(const char* path) const;
+
+            /// @brief PNG of the framebuffer, stored with uncompressed deflate blocks
+            /// @return false if the file could not be written
+            bool writePNG(const char* path) const;
+
+            /// @brief Pixels as 0x00rrggbb, row major from the top left corner
+            const uint32_t* pixels() const;
+            int getWidth() const;
+            int getHeight() const;
+            const RasterStats& getStats() const;
+
+        private:
+            enum class CommandType : unsigned char { Circle, Line, Polygon };
+
+            struct Command
+            {
+                CommandType type;
+                unsigned int color;
+                float alpha;
+                float x1, y1, x2, y2;   // circle: center and radius in x2, line: end points
+                unsigned int first;     // polygon: range in polygonVertices
+                unsigned int count;
+                int minX, minY, maxX, maxY;
+            };
+
+            struct Tile
+            {
+                int x0, y0, x1, y1;
+                std::vector<unsigned int> commands;
+            };
+
+            void push(Command& c);
+            void bin();
+            void rasterizeTiles();
+            void rasterize(const Tile& t, std::vector<float>& crossings);
+            void circle(const Tile& t, const Command& c);
+            void line(const Tile& t, const Command& c);
+            void polygon(const Tile& t, const Command& c, std::vector<float>& crossings);
+            void span(int y, int x0, int x1, const Command& c);
+            void blend(uint32_t& dst, const Command& c);
+
+            int width;
+            int height;
+            int tileSize;
+            int tilesX;
+            int tilesY;
+            unsigned int threadCount;
+
+            std::vector<uint32_t> framebuffer;
+            std::vector<Command> commands;
+            std::vector<Vector2> polygonVertices;
+            std::vector<Tile> tiles;
+            std::vector<std::vector<float>> crossings;  // polygon scanline buffer of each worker
+            JobSystem* jobs = nullptr;
+            std::atomic<size_t> nextTile{ 0 };
+            RasterStats stats;
+    };
+
+
+    inline SoftwareRenderer::SoftwareRenderer(int width, int height, int tileSize, unsigned int threads)
+        : width(width), height(height), tileSize(tileSize)
+    {
+        tilesX = (width + tileSize - 1) / tileSize;
+        tilesY = (height + tileSize - 1) / tileSize;
+        framebuffer.assign(static_cast<size_t>(width) * height, 0);
+
+        tiles.resize(static_cast<size_t>(tilesX) * tilesY);
+        for(int ty = 0; ty < tilesY; ty++)
+            for(int tx = 0; tx < tilesX; tx++) {
+                auto& t = tiles[ty * tilesX + tx];
+                t.x0 = tx * tileSize;
+                t.y0 = ty * tileSize;
+                t.x1 = std::min(t.x0 + tileSize, width) - 1;
+                t.y1 = std::min(t.y0 + tileSize, height) - 1;
+            }
+
+        setThreads(threads);
+    }
+
+    inline void SoftwareRenderer::setThreads(unsigned int threads)
+    {
+        threadCount = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        crossings.resize(std::max<size_t>(threadCount, jobs ? jobs->threads() : 0));
+    }
+
+    inline void SoftwareRenderer::setJobSystem(JobSystem* jobs)
+    {
+        this->jobs = jobs;
+        if(jobs)
+            crossings.resize(std::max<size_t>(crossings.size(), jobs->threads()));
+    }
+
+    inline void SoftwareRenderer::clear(unsigned int hex)
+    {
+        commands.clear();
+        polygonVertices.clear();
+        std::fill(framebuffer.begin(), framebuffer.end(), hex & 0xffffff);
+    }
+
+    inline void SoftwareRenderer::fillCircle(float x, float y, float radius, unsigned int hex, float alpha)
+    {
+        Command c{ CommandType::Circle, hex, alpha, x, y, radius, 0.0f, 0, 0,
+            (int)std::floor(x - radius), (int)std::floor(y - radius),
+            (int)std::ceil(x + radius), (int)std::ceil(y + radius) };
+        push(c);
+    }
+
+    inline void SoftwareRenderer::drawLine(float x1, float y1, float x2, float y2, unsigned int hex, float alpha)
+    {
+        Command c{ CommandType::Line, hex, alpha, x1, y1, x2, y2, 0, 0,
+            (int)std::floor(std::min(x1, x2)), (int)std::floor(std::min(y1, y2)),
+            (int)std::ceil(std::max(x1, x2)), (int)std::ceil(std::max(y1, y2)) };
+        push(c);
+    }
+
+    inline void SoftwareRenderer::fillPolygon(const Vector2* vertices, size_t count, unsigned int hex, float alpha)
+    {
+        if(count < 3)
+            return;
+
+        Command c{ CommandType::Polygon, hex, alpha, 0.0f, 0.0f, 0.0f, 0.0f,
+            static_cast<unsigned int>(polygonVertices.size()), static_cast<unsigned int>(count), 0, 0, 0, 0 };
+        float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+        for(size_t i = 0; i < count; i++) {
+            polygonVertices.push_back(vertices[i]);
+            minX = std::min(minX, vertices[i].x);
+            maxX = std::max(maxX, vertices[i].x);
+            minY = std::min(minY, vertices[i].y);
+            maxY = std::max(maxY, vertices[i].y);
+        }
+        c.minX = (int)std::floor(minX);
+        c.maxX = (int)std::ceil(maxX);
+        c.minY = (int)std::floor(minY);
+        c.maxY = (int)std::ceil(maxY);
+        push(c);
+    }
+
+    inline void SoftwareRenderer::submit(const DrawList& list)
+    {
+        const auto& vertices = list.getVertices();
+        for(const auto& c: list.getCommands())
+        {
+            switch(c.type)
+            {
+                case DrawPrimitive::Circle: fillCircle(c.x1, c.y1, c.x2, c.color, c.alpha); break;
+                case DrawPrimitive::Line: drawLine(c.x1, c.y1, c.x2, c.y2, c.color, c.alpha); break;
+                case DrawPrimitive::Polygon: fillPolygon(vertices.data() + c.first, c.count, c.color, c.alpha); break;
+                case DrawPrimitive::CircleOutline: {
+                    const int segments = std::clamp((int)c.x2, 8, 64);
+                    for(int i = 0; i < segments; i++) {
+                        float a1 = i * 6.2831853f / segments, a2 = (i + 1) * 6.2831853f / segments;
+                        drawLine(c.x1 + std::cos(a1) * c.x2, c.y1 + std::sin(a1) * c.x2,
+                            c.x1 + std::cos(a2) * c.x2, c.y1 + std::sin(a2) * c.x2, c.color, c.alpha);
+                    }
+                    break;
+                }
+                default: break;
+            }
+        }
+    }
+
+    inline void SoftwareRenderer::push(Command& c)
+    {
+        // drop whatever is fully off screen before it reaches the bins
+        if(c.maxX < 0 || c.maxY < 0 || c.minX >= width || c.minY >= height || c.alpha <= 0.0f)
+            return;
+        c.minX = std::max(c.minX, 0);
+        c.minY = std::max(c.minY, 0);
+        c.maxX = std::min(c.maxX, width - 1);
+        c.maxY = std::min(c.maxY, height - 1);
+        commands.push_back(c);
+    }
+
+    inline void SoftwareRenderer::flush()
+    {
+        PHY_PROFILE_ZONE("SoftwareRenderer::flush");
+        stats = RasterStats{};
+        stats.commands = commands.size();
+        stats.tiles = tiles.size();
+        stats.threads = jobs ? jobs->threads() : threadCount;
+
+        bin();
+        rasterizeTiles();
+
+        for(auto& t: tiles) {
+            stats.binnedCommands += t.commands.size();
+            t.commands.clear();
+        }
+        commands.clear();
+        polygonVertices.clear();
+    }
+
+    inline void SoftwareRenderer::bin()
+    {
+        PHY_PROFILE_ZONE("SoftwareRenderer::bin");
+        for(unsigned int i = 0; i < commands.size(); i++)
+        {
+            const auto& c = commands[i];
+            for(int ty = c.minY / tileSize; ty <= c.maxY / tileSize; ty++)
+                for(int tx = c.minX / tileSize; tx <= c.maxX / tileSize; tx++)
+                    tiles[ty * tilesX + tx].commands.push_back(i);
+        }
+    }
+
+    inline void SoftwareRenderer::rasterizeTiles()
+    {
+        if(jobs) {
+            jobs->parallelFor(tiles.size(), [this](size_t begin, size_t end, unsigned int thread) {
+                PHY_PROFILE_ZONE("SoftwareRenderer::rasterize");
+                for(size_t i = begin; i < end; i++)
+                    if(!tiles[i].commands.empty())
+                        rasterize(tiles[i], crossings[thread]);
+            }, 1);
+            return;
+        }
+
+        nextTile = 0;
+        auto worker = [this](unsigned int index) {
+            PHY_PROFILE_ZONE("SoftwareRenderer::rasterize");
+            for(size_t i = nextTile++; i < tiles.size(); i = nextTile++)
+                if(!tiles[i].commands.empty())
+                    rasterize(tiles[i], crossings[index]);
+        };
+
+        const unsigned int n = std::min<size_t>(threadCount, tiles.size());
+        std::vector<std::thread> workers;
+        for(unsigned int i = 1; i < n; i++)
+            workers.emplace_back(worker, i);
+        worker(0);
+        for(auto& w: workers)
+            w.join();
+    }
+
+    inline void SoftwareRenderer::rasterize(const Tile& t, std::vector<float>& crossings)
+    {
+        for(auto i: t.commands)
+        {
+            const auto& c = commands[i];
+            switch(c.type)
+            {
+                case CommandType::Circle: circle(t, c); break;
+                case CommandType::Line: line(t, c); break;
+                case CommandType::Polygon: polygon(t, c, crossings); break;
+            }
+        }
+    }
+
+    inline void SoftwareRenderer::circle(const Tile& t, const Command& c)
+    {
+        const int y0 = std::max(t.y0, c.minY), y1 = std::min(t.y1, c.maxY);
+        const float r2 = c.x2 * c.x2;
+        for(int y = y0; y <= y1; y++)
+        {
+            // pixel centers inside the circle
+            float dy = y + 0.5f - c.y1;
+            float h = r2 - dy * dy;
+            if(h < 0.0f)
+                continue;
+            h = std::sqrt(h);
+            int x0 = (int)std::ceil(c.x1 - h - 0.5f);
+            int x1 = (int)std::floor(c.x1 + h - 0.5f);
+            span(y, std::max(x0, t.x0), std::min(x1, t.x1), c);
+        }
+    }
+
+    inline void SoftwareRenderer::line(const Tile& t, const Command& c)
+    {
+        // DDA along the major axis, restricted to the steps that can land in the tile
+        const float dx = c.x2 - c.x1, dy = c.y2 - c.y1;
+        const bool steep = std::fabs(dy) > std::fabs(dx);
+        const float length = steep ? std::fabs(dy) : std::fabs(dx);
+        const int steps = std::max(1, (int)std::ceil(length));
+        const float sx = dx / steps, sy = dy / steps;
+
+        int first = 0, last = steps;
+        const float major = steep ? c.y1 : c.x1;
+        const float step = steep ? sy : sx;
+        const int lo = steep ? t.y0 : t.x0, hi = steep ? t.y1 : t.x1;
+        if(step != 0.0f) {
+            float a = (lo - 1 - major) / step, b = (hi + 1 - major) / step;
+            if(a > b) std::swap(a, b);
+            first = std::max(first, (int)std::floor(a));
+            last = std::min(last, (int)std::ceil(b));
+        }
+
+        for(int i = first; i <= last; i++)
+        {
+            int x = (int)std::floor(c.x1 + sx * i);
+            int y = (int)std::floor(c.y1 + sy * i);
+            if(x >= t.x0 && x <= t.x1 && y >= t.y0 && y <= t.y1)
+                blend(framebuffer[static_cast<size_t>(y) * width + x], c);
+        }
+    }
+
+    inline void SoftwareRenderer::polygon(const Tile& t, const Command& c, std::vector<float>& crossings)
+    {
+        const Vector2* v = polygonVertices.data() + c.first;
+        const int y0 = std::max(t.y0, c.minY), y1 = std::min(t.y1, c.maxY);
+        for(int y = y0; y <= y1; y++)
+        {
+            const float py = y + 0.5f;
+            crossings.clear();
+            for(unsigned int i = 0; i < c.count; i++)
+            {
+                const Vector2& a = v[i];
+                const Vector2& b = v[(i + 1) % c.count];
+                if((a.y <= py) != (b.y <= py))
+                    crossings.push_back(a.x + (py - a.y) * (b.x - a.x) / (b.y - a.y));
+            }
+            std::sort(crossings.begin(), crossings.end());
+
+            for(size_t i = 0; i + 1 < crossings.size(); i += 2)
+            {
+                int x0 = (int)std::ceil(crossings[i] - 0.5f);
+                int x1 = (int)std::floor(crossings[i + 1] - 0.5f);
+                span(y, std::max(x0, t.x0), std::min(x1, t.x1), c);
+            }
+        }
+    }
+
+    inline void SoftwareRenderer::span(int y, int x0, int x1, const Command& c)
+    {
+        if(x0 > x1)
+            return;
+        uint32_t* row = framebuffer.data() + static_cast<size_t>(y) * width;
+        if(c.alpha >= 1.0f) {
+            std::fill(row + x0, row + x1 + 1, c.color & 0xffffff);
+            return;
+        }
+        for(int x = x0; x <= x1; x++)
+            blend(row[x], c);
+    }
+
+    inline void SoftwareRenderer::blend(uint32_t& dst, const Command& c)
+    {
+        if(c.alpha >= 1.0f) {
+            dst = c.color & 0xffffff;
+            return;
+        }
+        const unsigned int a = (unsigned int)(c.alpha * 256.0f);
+        uint32_t rb = ((c.color & 0xff00ff) * a + (dst & 0xff00ff) * (256 - a)) >> 8;
+        uint32_t g = ((c.color & 0x00ff00) * a + (dst & 0x00ff00) * (256 - a)) >> 8;
+        dst = (rb & 0xff00ff) | (g & 0x00ff00);
+    }
+
+    inline bool SoftwareRenderer::writePPM(const char* path) const
+    {
+        FILE* file = std::fopen(path, "wb");
+        if(!file)
+            return false;
+
+        std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+        std::vector<unsigned char> row(static_cast<size_t>(width) * 3);
+        for(int y = 0; y < height; y++)
+        {
+            for(int x = 0; x < width; x++) {
+                uint32_t p = framebuffer[static_cast<size_t>(y) * width + x];
+                row[x * 3] = (p >> 16) & 0xff;
+                row[x * 3 + 1] = (p >> 8) & 0xff;
+                row[x * 3 + 2] = p & 0xff;
+            }
+            std::fwrite(row.data(), 1, row.size(), file);
+        }
+        return std::fclose(file) == 0;
+    }
+
+    inline bool SoftwareRenderer::writePNG(const char* path) const
+    {
+        static const std::array<uint32_t, 256> crcTable = []() {
+            std::array<uint32_t, 256> table;
+            for(uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for(int k = 0; k < 8; k++)
+                    c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+            return table;
+        }();
+
+        auto be32 = [](std::vector<unsigned char>& out, uint32_t v) {
+            out.push_back(v >> 24); out.push_back(v >> 16); out.push_back(v >> 8); out.push_back(v);
+        };
+
+        auto chunk = [&](std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data) {
+            be32(out, static_cast<uint32_t>(data.size()));
+            const size_t start = out.size();
+            out.insert(out.end(), type, type + 4);
+            out.insert(out.end(), data.begin(), data.end());
+            uint32_t crc = 0xffffffffu;
+            for(size_t i = start; i < out.size(); i++)
+                crc = crcTable[(crc ^ out[i]) & 0xff] ^ (crc >> 8);
+            be32(out, crc ^ 0xffffffffu);
+        };
+
+        // raw scanlines, each prefixed with filter type 0
+        std::vector<unsigned char> raw;
+        raw.reserve(static_cast<size_t>(width * 3 + 1) * height);
+        for(int y = 0; y < height; y++) {
+            raw.push_back(0);
+            for(int x = 0; x < width; x++) {
+                uint32_t p = framebuffer[static_cast<size_t>(y) * width + x];
+                raw.push_back((p >> 16) & 0xff);
+                raw.push_back((p >> 8) & 0xff);
+                raw.push_back(p & 0xff);
+            }
+        }
+
+        // zlib stream made of stored deflate blocks of at most 65535 bytes
+        std::vector<unsigned char> zlib = { 0x78, 0x01 };
+        uint32_t s1 = 1, s2 = 0;
+        for(size_t pos = 0; pos < raw.size() || pos == 0; )
+        {
+            const size_t n = std::min<size_t>(65535, raw.size() - pos);
+            zlib.push_back(pos + n == raw.size() ? 1 : 0);
+            zlib.push_back(n & 0xff); zlib.push_back(n >> 8);
+            zlib.push_back(~n & 0xff); zlib.push_back((~n >> 8) & 0xff);
+            for(size_t i = pos; i < pos + n; i++) {
+                zlib.push_back(raw[i]);
+                s1 = (s1 + raw[i]) % 65521;
+                s2 = (s2 + s1) % 65521;
+            }
+            pos += n;
+            if(pos == raw.size())
+                break;
+        }
+        be32(zlib, (s2 << 16) | s1);
+
+        std::vector<unsigned char> header;
+        be32(header, width);
+        be32(header, height);
+        header.insert(header.end(), { 8, 2, 0, 0, 0 });    // 8 bit rgb, no interlace
+
+        std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        chunk(png, "IHDR", header);
+        chunk(png, "IDAT", zlib);
+        chunk(png, "IEND", {});
+
+        FILE* file = std::fopen(path, "wb");
+        if(!file)
+            return false;
+        std::fwrite(png.data(), 1, png.size(), file);
+        return std::fclose(file) == 0;
+    }
+
+    inline const uint32_t* SoftwareRenderer::pixels() const
+    {
+        return framebuffer.data();
+    }
+
+    inline int SoftwareRenderer::getWidth() const
+    {
+        return width;
+    }
+
+    inline int SoftwareRenderer::getHeight() const
+    {
+        return height;
+    }
+
+    inline const RasterStats& SoftwareRenderer::getStats() const
+    {
+        return stats;
+    }
+
+} // namespace phy
+
+
+#endif
@@ -0,0 +1,289 @@
+/**
+ * Work counters and step time histograms of a World.
+ *
+ * Every thread taking part in a step adds to its own cache line sized
+ * block of counters, the blocks are only summed once the step is over so
+ * counting never shares a cache line between threads. Step times go into a
+ * log-linear (HDR style) histogram: values are kept within about 6% relative
+ * error from nanoseconds to centuries in a fixed array, so percentiles are
+ * cheap to record and to query however long the run.
+ */
+#ifndef __BYTENOL_PCGA_STATS_H__
+#define __BYTENOL_PCGA_STATS_H__
+
+#include <array>
+#include <bit>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+
+namespace phy
+{
+    enum class Counter : unsigned int
+    {
+        Bodies = 0,
+        Proxies,
+        CandidatePairs,     // pairs out of the broadphase
+        SatAxes,            // separating axes tried by the narrowphase
+        EarlyOuts,          // candidate pairs that turned out not to touch
+        Contacts,
+        SolverIterations,
+        BytesAllocated,     // growth of the step's scratch buffers
+        Count
+    };
+
+    inline constexpr const char* counterNames[] = {
+        "bodies", "proxies", "candidate_pairs", "sat_axes",
+        "early_outs", "contacts", "solver_iterations", "bytes_allocated"
+    };
+
+    static_assert(std::size(counterNames) == (size_t)Counter::Count);
+
+    /// @brief One thread's counters, padded so neighbouring blocks never share a cache line
+    struct alignas(64) StepCounters
+    {
+        std::array<uint64_t, (size_t)Counter::Count> values{};
+
+        void add(Counter c, uint64_t n = 1);
+        uint64_t operator[](Counter c) const;
+        void clear();
+    };
+
+    /**
+     * Histogram of positive integers (nanoseconds here). Values below 32 get
+     * a bucket each, above that every power of two is split in 16 buckets.
+     */
+    class Histogram
+    {
+        public:
+            void record(uint64_t value);
+
+            /// @brief Value below which a fraction p of the records fall, within the bucket precision
+            uint64_t percentile(double p) const;
+
+            uint64_t count() const;
+            uint64_t max() const;
+            double mean() const;
+            void reset();
+
+        private:
+            static constexpr unsigned int subBits = 5;
+            static constexpr unsigned int subCount = 1u << subBits;
+            static constexpr size_t bucketCount = subCount + (64 - subBits) * (subCount / 2);
+
+            static size_t bucketOf(uint64_t value);
+            static uint64_t highestOf(size_t bucket);
+
+            std::array<uint64_t, bucketCount> buckets{};
+            uint64_t total = 0;
+            uint64_t largest = 0;
+            double sum = 0.0;
+    };
+
+    class Stats
+    {
+        public:
+            explicit Stats(unsigned int threads = 1);
+
+            /// @brief Number of counter blocks, one per thread taking part in a step
+            void setThreads(unsigned int threads);
+            unsigned int getThreads() const;
+
+            /// @brief Counters of the given thread, only that thread may write them
+            StepCounters& local(unsigned int thread = 0);
+
+            /// @brief Clear the thread counters before a step
+            void beginStep();
+
+            /// @brief Merge the thread counters and record the step time
+            void endStep(uint64_t stepNs);
+
+            /// @brief Counters of the last step
+            const StepCounters& lastStep() const;
+
+            /// @brief Counters summed over every step since the last reset
+            const StepCounters& totals() const;
+
+            const Histogram& stepTimes() const;
+            uint64_t steps() const;
+            void reset();
+
+            /// @brief Counter totals, per step means and step time percentiles
+            void print(std::ostream& out) const;
+
+        private:
+            std::vector<StepCounters> threadCounters;
+            StepCounters last;
+            StepCounters sum;
+            Histogram times;
+            uint64_t stepCount = 0;
+    };
+
+
+    inline void StepCounters::add(Counter c, uint64_t n)
+    {
+        values[(size_t)c] += n;
+    }
+
+    inline uint64_t StepCounters::operator[](Counter c) const
+    {
+        return values[(size_t)c];
+    }
+
+    inline void StepCounters::clear()
+    {
+        values.fill(0);
+    }
+
+    inline size_t Histogram::bucketOf(uint64_t value)
+    {
+        if(value < subCount)
+            return static_cast<size_t>(value);
+        // shift keeps the top subBits bits, the leading one picks the half
+        const unsigned int shift = std::bit_width(value) - subBits;
+        const uint64_t sub = value >> shift;
+        return subCount + (shift - 1) * (subCount / 2) + (sub - subCount / 2);
+    }
+
+    inline uint64_t Histogram::highestOf(size_t bucket)
+    {
+        if(bucket < subCount)
+            return bucket;
+        const size_t shift = (bucket - subCount) / (subCount / 2) + 1;
+        const uint64_t sub = (bucket - subCount) % (subCount / 2) + subCount / 2;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    inline void Histogram::record(uint64_t value)
+    {
+        buckets[bucketOf(value)]++;
+        total++;
+        largest = std::max(largest, value);
+        sum += static_cast<double>(value);
+    }
+
+    inline uint64_t Histogram::percentile(double p) const
+    {
+        if(total == 0)
+            return 0;
+
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * total + 0.5));
+        uint64_t seen = 0;
+        for(size_t i = 0; i < bucketCount; i++)
+        {
+            seen += buckets[i];
+            if(seen >= rank)
+                return std::min(highestOf(i), largest);
+        }
+        return largest;
+    }
+
+    inline uint64_t Histogram::count() const
+    {
+        return total;
+    }
+
+    inline uint64_t Histogram::max() const
+    {
+        return largest;
+    }
+
+    inline double Histogram::mean() const
+    {
+        return total ? sum / total : 0.0;
+    }
+
+    inline void Histogram::reset()
+    {
+        buckets.fill(0);
+        total = 0;
+        largest = 0;
+        sum = 0.0;
+    }
+
+    inline Stats::Stats(unsigned int threads)
+    {
+        setThreads(threads);
+    }
+
+    inline void Stats::setThreads(unsigned int threads)
+    {
+        threadCounters.resize(std::max(1u, threads));
+    }
+
+    inline unsigned int Stats::getThreads() const
+    {
+        return static_cast<unsigned int>(threadCounters.size());
+    }
+
+    inline StepCounters& Stats::local(unsigned int thread)
+    {
+        return threadCounters[thread];
+    }
+
+    inline void Stats::beginStep()
+    {
+        for(auto& c: threadCounters)
+            c.clear();
+    }
+
+    inline void Stats::endStep(uint64_t stepNs)
+    {
+        last.clear();
+        for(const auto& c: threadCounters)
+            for(size_t i = 0; i < last.values.size(); i++)
+                last.values[i] += c.values[i];
+
+        for(size_t i = 0; i < sum.values.size(); i++)
+            sum.values[i] += last.values[i];
+        times.record(stepNs);
+        stepCount++;
+    }
+
+    inline const StepCounters& Stats::lastStep() const
+    {
+        return last;
+    }
+
+    inline const StepCounters& Stats::totals() const
+    {
+        return sum;
+    }
+
+    inline const Histogram& Stats::stepTimes() const
+    {
+        return times;
+    }
+
+    inline uint64_t Stats::steps() const
+    {
+        return stepCount;
+    }
+
+    inline void Stats::reset()
+    {
+        beginStep();
+        last.clear();
+        sum.clear();
+        times.reset();
+        stepCount = 0;
+    }
+
+    inline void Stats::print(std::ostream& out) const
+    {
+        const double steps = std::max<uint64_t>(stepCount, 1);
+        out << std::fixed << std::setprecision(3) << "steps " << stepCount
+            << ", step ms p50 " << times.percentile(0.5) * 1e-6 << " p99 " << times.percentile(0.99) * 1e-6
+            << " max " << times.max() * 1e-6 << " mean " << times.mean() * 1e-6 << "\n";
+        for(size_t i = 0; i < (size_t)Counter::Count; i++)
+            out << "  " << std::left << std::setw(20) << counterNames[i] << std::right
+                << std::setw(14) << sum.values[i] << std::setprecision(1) << std::setw(14) << sum.values[i] / steps
+                << " per step\n";
+    }
+
+} // namespace phy
+
+
+#endif
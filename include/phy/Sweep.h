@@ -0,0 +1,199 @@
+#ifndef __BYTENOL_PCGA_SWEEP_H__
+#define __BYTENOL_PCGA_SWEEP_H__
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "Vector.h"
+#include "Ball.h"
+#include "Wall.h"
+#include "RigidBody.h"
+
+namespace phy {
+
+    /// @brief distance a ball is pushed off a surface after an impact so the
+    /// next sweep of the same step does not report the same contact at t = 0
+    constexpr float sweepSkin = 0.01f;
+
+    /// @brief Result of a swept (continuous) collision query
+    struct SweepHit
+    {
+        float toi = 1.0f;   // fraction of the motion at which the contact happens
+        Vector2 normal;     // points from the obstacle toward the circle
+        Vector2 point;      // contact point on the obstacle
+    };
+
+    /// @brief Sweep a circle against a single point (a segment end or a polygon corner)
+    /// @param center The circle center at the start of the motion
+    /// @param motion The displacement of the circle over the step
+    /// @param radius The circle radius
+    /// @param p The point to test against
+    /// @param hit is only overwritten if the impact is earlier than hit.toi
+    /// @return true if hit was updated
+    bool sweepCirclePoint(const Vector2& center, const Vector2& motion, float radius,
+        const Vector2& p, SweepHit& hit);
+
+    /// @brief Sweep a circle against the segment [a, b]
+    /// @param hit is only overwritten if the impact is earlier than hit.toi
+    /// @return true if hit was updated
+    bool sweepCircleSegment(const Vector2& center, const Vector2& motion, float radius,
+        const Vector2& a, const Vector2& b, SweepHit& hit);
+
+    /// @brief Sweep a ball moving with its velocity for dt against a wall
+    bool sweepBallWall(const Ball& ball, const Wall& wall, float dt, SweepHit& hit);
+
+    /// @brief Sweep a ball moving with its velocity for dt against every edge of
+    /// a closed polygon given in world space (e.g the transformed vertices)
+    bool sweepBallPolygon(const Ball& ball, const std::vector<Vector2>& vertices, float dt, SweepHit& hit);
+
+    /// @brief Sweep a circle against a body: the edges of its world space vertices,
+    /// or its center widened by its radius when it is a circle itself
+    bool sweepCircleBody(const Vector2& center, const Vector2& motion, float radius,
+        const RigidBody& body, SweepHit& hit);
+
+    /// @brief Move the ball by vel * dt without tunneling through walls or polygon edges.
+    /// The ball is advanced to the earliest time of impact, its velocity is reflected and
+    /// the rest of the step is swept again, up to maxIterations times. Motion left after
+    /// the last iteration is dropped so the ball never ends up on the other side.
+    /// @param ball The ball to move
+    /// @param dt The timestep
+    /// @param walls The walls to collide against
+    /// @param polygons World space vertices of convex polygons to collide against
+    /// @param restitution 1 for a perfectly elastic bounce, 0 to slide along the surface
+    /// @param maxIterations Maximum number of impacts resolved within the step
+    void advanceBall(Ball& ball, float dt, const std::vector<Wall>& walls,
+        const std::vector<std::vector<Vector2>>& polygons = {}, float restitution = 1.0f, int maxIterations = 4);
+
+
+    inline bool sweepCirclePoint(const Vector2& c, const Vector2& m, float r, const Vector2& p, SweepHit& hit)
+    {
+        // solve |c + m * t - p| = r for the smallest t
+        Vector2 d = c - p;
+        float a = m.dotProduct(m);
+        float b = d.dotProduct(m);
+        float k = d.dotProduct(d) - r * r;
+
+        float t = 0.0f;
+        if(k < 0.0f) {
+            // already overlapping, only report it if the circle moves further in
+            if(b >= 0.0f) return false;
+        } else {
+            if(a == 0.0f) return false;
+            float disc = b * b - a * k;
+            if(disc < 0.0f) return false;
+            t = (-b - std::sqrt(disc)) / a;
+            if(t < 0.0f) return false;
+        }
+
+        if(t >= hit.toi) return false;
+
+        hit.toi = t;
+        hit.normal = (d + m * t).normalize();
+        hit.point = p;
+        return true;
+    }
+
+    inline bool sweepCircleSegment(const Vector2& c, const Vector2& m, float r, const Vector2& a, const Vector2& b, SweepHit& hit)
+    {
+        Vector2 edge = b - a;
+        float len = edge.getLength();
+        if(len == 0.0f)
+            return sweepCirclePoint(c, m, r, a, hit);
+
+        Vector2 dir = edge * (1.0f / len);
+        Vector2 normal{ dir.y, -dir.x };
+
+        // make the normal face the circle
+        float dist = (c - a).dotProduct(normal);
+        if(dist < 0.0f) {
+            normal *= -1.0f;
+            dist = -dist;
+        }
+
+        // face of the segment, offset by the radius
+        float approach = m.dotProduct(normal);
+        if(approach < 0.0f)
+        {
+            float t = std::max((r - dist) / approach, 0.0f);
+            if(t >= hit.toi) return false;
+
+            float s = (c + m * t - a).dotProduct(dir);
+            if(s >= 0.0f && s <= len) {
+                hit.toi = t;
+                hit.normal = normal;
+                hit.point = a + dir * s;
+                return true;
+            }
+        }
+
+        // the circle misses the face, it can only touch the end points
+        bool found = sweepCirclePoint(c, m, r, a, hit);
+        found |= sweepCirclePoint(c, m, r, b, hit);
+        return found;
+    }
+
+    inline bool sweepBallWall(const Ball& ball, const Wall& wall, float dt, SweepHit& hit)
+    {
+        return sweepCircleSegment(ball.pos, ball.vel * dt, ball.radius, wall.start, wall.end, hit);
+    }
+
+    inline bool sweepBallPolygon(const Ball& ball, const std::vector<Vector2>& vertices, float dt, SweepHit& hit)
+    {
+        const Vector2 motion = ball.vel * dt;
+        bool found = false;
+        for(size_t i = 0; i < vertices.size(); i++)
+        {
+            const auto& p1 = vertices[i];
+            const auto& p2 = vertices[(i + 1) % vertices.size()];
+            found |= sweepCircleSegment(ball.pos, motion, ball.radius, p1, p2, hit);
+        }
+        return found;
+    }
+
+    inline bool sweepCircleBody(const Vector2& center, const Vector2& motion, float radius,
+        const RigidBody& body, SweepHit& hit)
+    {
+        if(body.vertices.empty()) {
+            if(!sweepCirclePoint(center, motion, radius + body.radius, body.pos, hit))
+                return false;
+            hit.point = body.pos + hit.normal * body.radius;
+            return true;
+        }
+
+        const auto& v = body.transformed;
+        bool found = false;
+        for(size_t i = 0; i < v.size(); i++)
+            found |= sweepCircleSegment(center, motion, radius, v[i], v[(i + 1) % v.size()], hit);
+        return found;
+    }
+
+    inline void advanceBall(Ball& ball, float dt, const std::vector<Wall>& walls,
+        const std::vector<std::vector<Vector2>>& polygons, float restitution, int maxIterations)
+    {
+        float remaining = dt;
+        for(int i = 0; i < maxIterations && remaining > 0.0f; i++)
+        {
+            SweepHit hit;
+            bool collided = false;
+            for(const auto& wall: walls)
+                collided |= sweepBallWall(ball, wall, remaining, hit);
+            for(const auto& polygon: polygons)
+                collided |= sweepBallPolygon(ball, polygon, remaining, hit);
+
+            if(!collided) {
+                ball.pos += ball.vel * remaining;
+                return;
+            }
+
+            ball.pos += ball.vel * (remaining * hit.toi) + hit.normal * sweepSkin;
+
+            float vn = ball.vel.dotProduct(hit.normal);
+            if(vn < 0.0f)
+                ball.vel -= hit.normal * ((1.0f + restitution) * vn);
+
+            remaining -= remaining * hit.toi;
+        }
+    }
+}
+
+#endif
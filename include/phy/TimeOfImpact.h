@@ -0,0 +1,476 @@
+/**
+ * Conservative advancement time of impact for convex polygons and circles
+ * that move and rotate during a step. Distances go through the same
+ * [ShapeType][ShapeType] dispatch as the narrowphase. Only bodies flagged with RigidBody::isBullet
+ * go through it: each bullet is sub-stepped together with the bodies its
+ * sweep can reach, every other body is integrated once with the full dt.
+ */
+#ifndef __BYTENOL_PCGA_TIME_OF_IMPACT_H__
+#define __BYTENOL_PCGA_TIME_OF_IMPACT_H__
+
+#include <vector>
+#include <cmath>
+#include <numbers>
+#include <utility>
+#include <algorithm>
+#include "Vector.h"
+#include "RigidBody.h"
+#include "Narrowphase.h"
+
+namespace phy
+{
+    /// @brief Result of a time of impact query
+    struct ImpactInfo
+    {
+        float toi = 0.0f;   // time in seconds from the start of the step
+        Vector2 normal;     // points from the first body toward the second one
+    };
+
+    /// @brief Largest distance from the body origin to any of its vertices
+    float boundingRadius(const vertices_t& vertices);
+
+    /// @brief Bounding radius of a body, circles use their radius
+    float bodyRadius(const RigidBody& body);
+
+    /// @brief Rotate (in degrees, like Vector2::rotate) and translate vertices into out
+    void transformVertices(const vertices_t& vertices, const Vector2& pos, float rotation, vertices_t& out);
+
+    /// @brief Closest distance between two convex polygons in world space
+    /// @param normal receives the direction from a to b of the closest features
+    /// @return 0 if the polygons overlap
+    float polygonDistance(const vertices_t& a, const vertices_t& b, Vector2& normal);
+
+    using DistanceFn = float (*)(const Shape& a, const Shape& b, Vector2& normal);
+
+    float circlesDistance(const Shape& a, const Shape& b, Vector2& normal);
+    float circlePolygonDistance(const Shape& a, const Shape& b, Vector2& normal);
+    float polygonCircleDistance(const Shape& a, const Shape& b, Vector2& normal);
+    float polygonsDistance(const Shape& a, const Shape& b, Vector2& normal);
+
+    /// @brief Distance functions indexed by [a.type][b.type]
+    inline constexpr DistanceFn distanceTable[(int)ShapeType::Count][(int)ShapeType::Count] = {
+        { circlesDistance, circlePolygonDistance },
+        { polygonCircleDistance, polygonsDistance },
+    };
+
+    /// @brief Closest distance between two shapes, like polygonDistance
+    inline float shapeDistance(const Shape& a, const Shape& b, Vector2& normal)
+    {
+        return distanceTable[(int)a.type][(int)b.type](a, b, normal);
+    }
+
+    /// @brief Shape of a body moved along its velocities for t, polygons are transformed into out
+    Shape bodyShape(const RigidBody& body, float t, vertices_t& out);
+
+    /// @brief Conservative advancement: step both bodies forward by the largest time
+    /// that cannot make them touch, given their linear and angular velocities, until
+    /// they are closer than tolerance
+    /// @param a The first body
+    /// @param b The second body
+    /// @param dt The time span to search
+    /// @param info receives the time of impact and the contact normal
+    /// @param tolerance The distance at which the bodies are considered touching
+    /// @param maxIterations Maximum number of advancement steps
+    /// @return true if the bodies touch within dt. Bodies overlapping from the start
+    /// only have an impact at 0, along the narrowphase normal, while they approach
+    bool timeOfImpact(const RigidBody& a, const RigidBody& b, float dt, ImpactInfo& info,
+        float tolerance = 0.1f, int maxIterations = 20);
+
+    /// @brief Buffers of integrateBodies, kept between calls so a step does not allocate
+    struct IntegrationScratch
+    {
+        std::vector<char> handled;
+        std::vector<size_t> group;
+        vertices_t va;      // the two bodies of a time of impact query
+        vertices_t vb;
+    };
+
+    /// @brief timeOfImpact transforming the vertices into the buffers of scratch
+    bool timeOfImpact(const RigidBody& a, const RigidBody& b, float dt, ImpactInfo& info,
+        IntegrationScratch& scratch, float tolerance = 0.1f, int maxIterations = 20);
+
+    /// @brief Integrate the bodies for dt. Bullets are sub-stepped against the bodies
+    /// their sweep can reach, up to maxSubSteps impacts, everything else moves once.
+    void integrateBodies(std::vector<RigidBody>& bodies, float dt, float restitution = 1.0f, int maxSubSteps = 4);
+
+    /// @brief integrateBodies reusing the buffers of scratch
+    void integrateBodies(std::vector<RigidBody>& bodies, float dt, IntegrationScratch& scratch,
+        float restitution = 1.0f, int maxSubSteps = 4);
+
+    /// @brief First half of integrateBodies: sub-step the bullets and the bodies their
+    /// sweep reaches, marking those in scratch.handled
+    void integrateBullets(std::vector<RigidBody>& bodies, float dt, IntegrationScratch& scratch,
+        float restitution = 1.0f, int maxSubSteps = 4);
+
+    /// @brief Second half of integrateBodies: advance the awake bodies of [begin, end)
+    /// integrateBullets left alone, ranges can run on different threads
+    void advanceBodies(std::vector<RigidBody>& bodies, size_t begin, size_t end, float dt,
+        const IntegrationScratch& scratch);
+
+
+    inline float boundingRadius(const vertices_t& vertices)
+    {
+        float r = 0.0f;
+        for(const auto& v: vertices)
+            r = std::max(r, v.getLength());
+        return r;
+    }
+
+    inline float bodyRadius(const RigidBody& body)
+    {
+        return body.vertices.empty() ? body.radius : boundingRadius(body.vertices);
+    }
+
+    inline void transformVertices(const vertices_t& vertices, const Vector2& pos, float rotation, vertices_t& out)
+    {
+        out.resize(vertices.size());
+        for(size_t i = 0; i < vertices.size(); i++)
+        {
+            Vector2 v = vertices[i];
+            out[i] = pos + v.rotate(rotation);
+        }
+    }
+
+    /// @brief Distance from p to the segment [a, b], closest receives the point on the segment
+    inline float pointSegmentDistance(const Vector2& p, const Vector2& a, const Vector2& b, Vector2& closest)
+    {
+        Vector2 ab = b - a;
+        float l2 = ab.dotProduct(ab);
+        float t = l2 == 0.0f ? 0.0f : std::clamp((p - a).dotProduct(ab) / l2, 0.0f, 1.0f);
+        closest = a + ab * t;
+        return (p - closest).getLength();
+    }
+
+    /// @brief Separating axis test of two convex polygons given as vertex arrays
+    inline bool polygonsOverlap(const Vector2* a, size_t na, const Vector2* b, size_t nb)
+    {
+        for(int pass = 0; pass < 2; pass++, std::swap(a, b), std::swap(na, nb))
+        {
+            for(size_t i = 0; i < na; i++)
+            {
+                auto vDir = a[(i + 1) % na] - a[i];
+                Vector2 axis{ vDir.y, -vDir.x };
+
+                float min_1 = INFINITY, max_1 = -INFINITY;
+                for(size_t k = 0; k < na; k++) {
+                    float dp = a[k].dotProduct(axis);
+                    min_1 = std::min(min_1, dp);
+                    max_1 = std::max(max_1, dp);
+                }
+
+                float min_2 = INFINITY, max_2 = -INFINITY;
+                for(size_t k = 0; k < nb; k++) {
+                    float dp = b[k].dotProduct(axis);
+                    min_2 = std::min(min_2, dp);
+                    max_2 = std::max(max_2, dp);
+                }
+
+                if(!(min_1 <= max_2 && min_2 <= max_1))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    inline bool polygonsOverlap(const vertices_t& a, const vertices_t& b)
+    {
+        return polygonsOverlap(a.data(), a.size(), b.data(), b.size());
+    }
+
+    inline float polygonDistance(const vertices_t& a, const vertices_t& b, Vector2& normal)
+    {
+        return polygonsDistance(polygonShape({}, a), polygonShape({}, b), normal);
+    }
+
+    inline float circlesDistance(const Shape& a, const Shape& b, Vector2& normal)
+    {
+        const Vector2 d = b.center - a.center;
+        const float length = d.getLength();
+        if(length <= a.radius + b.radius) {
+            normal = Vector2{};
+            return 0.0f;
+        }
+        normal = d * (1.0f / length);
+        return length - a.radius - b.radius;
+    }
+
+    inline float circlePolygonDistance(const Shape& a, const Shape& b, Vector2& normal)
+    {
+        // the center is inside when it is on the same side of every edge
+        float best = INFINITY;
+        Vector2 closest, nearest;
+        bool left = true, right = true;
+        for(unsigned int i = 0; i < b.count; i++)
+        {
+            const auto& e1 = b.vertices[i];
+            const auto& e2 = b.vertices[(i + 1) % b.count];
+            const Vector2 edge = e2 - e1;
+            const Vector2 toCenter = a.center - e1;
+            const float side = edge.x * toCenter.y - edge.y * toCenter.x;
+            left = left && side >= 0.0f;
+            right = right && side <= 0.0f;
+
+            float d = pointSegmentDistance(a.center, e1, e2, closest);
+            if(d < best) {
+                best = d;
+                nearest = closest;
+            }
+        }
+
+        if(left || right || best <= a.radius) {
+            normal = Vector2{};
+            return 0.0f;
+        }
+        normal = (nearest - a.center) * (1.0f / best);
+        return best - a.radius;
+    }
+
+    inline float polygonCircleDistance(const Shape& a, const Shape& b, Vector2& normal)
+    {
+        const float d = circlePolygonDistance(b, a, normal);
+        normal *= -1.0f;
+        return d;
+    }
+
+    inline float polygonsDistance(const Shape& a, const Shape& b, Vector2& normal)
+    {
+        if(polygonsOverlap(a.vertices, a.count, b.vertices, b.count)) {
+            normal = Vector2{};
+            return 0.0f;
+        }
+
+        // for disjoint convex polygons the closest features are always a vertex of
+        // one polygon against an edge of the other one
+        float best = INFINITY;
+        Vector2 closest;
+        for(unsigned int i = 0; i < b.count; i++)
+        {
+            const auto& e1 = b.vertices[i];
+            const auto& e2 = b.vertices[(i + 1) % b.count];
+            for(unsigned int k = 0; k < a.count; k++) {
+                const auto& p = a.vertices[k];
+                float d = pointSegmentDistance(p, e1, e2, closest);
+                if(d < best) {
+                    best = d;
+                    normal = closest - p;
+                }
+            }
+        }
+
+        for(unsigned int i = 0; i < a.count; i++)
+        {
+            const auto& e1 = a.vertices[i];
+            const auto& e2 = a.vertices[(i + 1) % a.count];
+            for(unsigned int k = 0; k < b.count; k++) {
+                const auto& p = b.vertices[k];
+                float d = pointSegmentDistance(p, e1, e2, closest);
+                if(d < best) {
+                    best = d;
+                    normal = p - closest;
+                }
+            }
+        }
+
+        normal.normalize();
+        return best;
+    }
+
+    inline Shape bodyShape(const RigidBody& body, float t, vertices_t& out)
+    {
+        const Vector2 pos = body.pos + body.vel * t;
+        if(body.vertices.empty()) {
+            Shape s;
+            s.type = ShapeType::Circle;
+            s.center = pos;
+            s.radius = body.radius;
+            return s;
+        }
+        transformVertices(body.vertices, pos, body.rotation + body.angVel * t, out);
+        return polygonShape(pos, out);
+    }
+
+    inline bool timeOfImpact(const RigidBody& a, const RigidBody& b, float dt, ImpactInfo& info,
+        float tolerance, int maxIterations)
+    {
+        IntegrationScratch scratch;
+        return timeOfImpact(a, b, dt, info, scratch, tolerance, maxIterations);
+    }
+
+    inline bool timeOfImpact(const RigidBody& a, const RigidBody& b, float dt, ImpactInfo& info,
+        IntegrationScratch& scratch, float tolerance, int maxIterations)
+    {
+        constexpr float toRadians = std::numbers::pi_v<float> / 180.0f;
+
+        // no point of a rotating body moves faster than angVel * boundingRadius,
+        // circles have no vertices and their rotation moves no point of the surface
+        const float angularBound = (std::abs(a.angVel) * boundingRadius(a.vertices) +
+            std::abs(b.angVel) * boundingRadius(b.vertices)) * toRadians;
+        const Vector2 relVel = a.vel - b.vel;
+
+        auto& va = scratch.va;
+        auto& vb = scratch.vb;
+        float t = 0.0f, last = 0.0f;
+        Vector2 lastNormal;
+        for(int i = 0; i < maxIterations; i++)
+        {
+            Vector2 normal;
+            const Shape sa = bodyShape(a, t, va), sb = bodyShape(b, t, vb);
+            float d = shapeDistance(sa, sb, normal);
+            float closing = relVel.dotProduct(normal);
+
+            // an overlap has no distance normal: from the start the contact normal tells
+            // whether the bodies still approach, after an advancement the last pose
+            // still apart is the impact
+            if(d <= 0.0f) {
+                if(i == 0) {
+                    Manifold m;
+                    if(!collide(sa, sb, m) || relVel.dotProduct(m.normal) <= 0.0f)
+                        return false;
+                    info.toi = 0.0f;
+                    info.normal = m.normal;
+                    return true;
+                }
+                info.toi = last;
+                info.normal = lastNormal;
+                return true;
+            }
+
+            if(d <= tolerance) {
+                // touching but moving apart is not an impact
+                if(closing <= 0.0f)
+                    return false;
+                info.toi = t;
+                info.normal = normal;
+                return true;
+            }
+
+            float bound = std::max(closing, 0.0f) + angularBound;
+            if(bound <= 0.0f)
+                return false;
+
+            last = t;
+            lastNormal = normal;
+            t += (d - tolerance * 0.5f) / bound;
+            if(t > dt)
+                return false;
+        }
+
+        // ran out of iterations while still approaching: be conservative, with
+        // the normal of the poses at t
+        info.toi = t;
+        if(shapeDistance(bodyShape(a, t, va), bodyShape(b, t, vb), info.normal) <= 0.0f)
+            info.normal = (b.pos + b.vel * t - a.pos - a.vel * t).normalize();
+        return true;
+    }
+
+    /// @brief Advance a body by dt without any collision handling
+    inline void advanceBody(RigidBody& body, float dt)
+    {
+        body.pos += body.vel * dt;
+        body.rotation += body.angVel * dt;
+    }
+
+    /// @brief Sub-step a bullet together with the bodies its sweep can reach
+    inline void stepBulletGroup(std::vector<RigidBody>& bodies, IntegrationScratch& scratch,
+        float dt, float restitution, int maxSubSteps)
+    {
+        const auto& group = scratch.group;
+        RigidBody& bullet = bodies[group.front()];
+        float remaining = dt;
+
+        for(int s = 0; s < maxSubSteps && remaining > 0.0f; s++)
+        {
+            ImpactInfo first;
+            first.toi = INFINITY;
+            size_t partner = 0;
+            for(size_t k = 1; k < group.size(); k++)
+            {
+                ImpactInfo info;
+                if(timeOfImpact(bullet, bodies[group[k]], remaining, info, scratch) && info.toi < first.toi) {
+                    first = info;
+                    partner = group[k];
+                }
+            }
+
+            if(first.toi == INFINITY) {
+                for(auto i: group) advanceBody(bodies[i], remaining);
+                return;
+            }
+
+            for(auto i: group) advanceBody(bodies[i], first.toi);
+            remaining -= first.toi;
+
+            // linear impulse along the contact normal
+            RigidBody& other = bodies[partner];
+            float vn = (bullet.vel - other.vel).dotProduct(first.normal);
+            const float invMassSum = bullet.invMass() + other.invMass();
+            if(vn > 0.0f && invMassSum > 0.0f) {
+                float j = (1.0f + restitution) * vn / invMassSum;
+                bullet.vel -= first.normal * (j * bullet.invMass());
+                other.vel += first.normal * (j * other.invMass());
+                other.awake = true;
+                other.sleepCounter = 0;
+            }
+        }
+        // whatever motion is left after the last sub-step is dropped
+    }
+
+    inline void integrateBodies(std::vector<RigidBody>& bodies, float dt, float restitution, int maxSubSteps)
+    {
+        IntegrationScratch scratch;
+        integrateBodies(bodies, dt, scratch, restitution, maxSubSteps);
+    }
+
+    inline void integrateBodies(std::vector<RigidBody>& bodies, float dt, IntegrationScratch& scratch,
+        float restitution, int maxSubSteps)
+    {
+        integrateBullets(bodies, dt, scratch, restitution, maxSubSteps);
+        advanceBodies(bodies, 0, bodies.size(), dt, scratch);
+    }
+
+    inline void integrateBullets(std::vector<RigidBody>& bodies, float dt, IntegrationScratch& scratch,
+        float restitution, int maxSubSteps)
+    {
+        // only awake dynamic bodies move, the others can still be hit by a bullet
+        auto& handled = scratch.handled;
+        auto& group = scratch.group;
+        handled.assign(bodies.size(), 0);
+
+        for(size_t i = 0; i < bodies.size(); i++)
+        {
+            if(!bodies[i].isBullet || handled[i] || !bodies[i].awake || bodies[i].isStatic())
+                continue;
+
+            // the bullet and everything whose bounds its sweep overlaps over dt. Other
+            // bullets get their own group: a group member only moves along its velocity,
+            // so a bullet knocked by this one would leave through the next wall
+            const auto& bullet = bodies[i];
+            const float r = bodyRadius(bullet);
+            group.assign(1, i);
+            for(size_t j = 0; j < bodies.size(); j++)
+            {
+                if(j == i || handled[j] || bodies[j].isBullet) continue;
+                const auto& other = bodies[j];
+                float reach = r + bodyRadius(other) + (bullet.vel - other.vel).getLength() * dt;
+                if((other.pos - bullet.pos).getLength() <= reach)
+                    group.push_back(j);
+            }
+
+            for(auto k: group)
+                if(!bodies[k].isStatic()) handled[k] = 1;
+            stepBulletGroup(bodies, scratch, dt, restitution, maxSubSteps);
+        }
+    }
+
+    inline void advanceBodies(std::vector<RigidBody>& bodies, size_t begin, size_t end, float dt,
+        const IntegrationScratch& scratch)
+    {
+        for(size_t i = begin; i < end; i++)
+            if(!scratch.handled[i] && bodies[i].awake && !bodies[i].isStatic())
+                advanceBody(bodies[i], dt);
+    }
+
+} // namespace phy
+
+
+#endif
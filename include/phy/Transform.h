@@ -0,0 +1,203 @@
+#ifndef __BYTENOL_PCGA_TRANSFORM_H__
+#define __BYTENOL_PCGA_TRANSFORM_H__
+
+#include <cmath>
+#include <cstddef>
+#include "Vector.h"
+
+namespace phy
+{
+    /**
+     * 2D affine transform
+     *  | a  c  tx |
+     *  | b  d  ty |
+     *  | 0  0  1  |
+     */
+    struct Affine2
+    {
+        float a = 1.0f;
+        float b = 0.0f;
+        float c = 0.0f;
+        float d = 1.0f;
+        float tx = 0.0f;
+        float ty = 0.0f;
+
+        Affine2 operator*(const Affine2& m) const;
+        Vector2 apply(const Vector2& v) const;
+
+        /// @brief The transform undoing this one, the identity if it is singular
+        Affine2 inverse() const;
+
+        /// @brief Write the transform as a column major 4x4 matrix for glUniformMatrix4fv
+        void toMat4(float out[16]) const;
+
+        static Affine2 translation(float x, float y);
+        static Affine2 scaling(float sx, float sy);
+
+        /// @brief Rotation in degrees, like Vector2::rotate
+        static Affine2 rotation(float angle);
+
+        /// @brief Map [0, w] x [0, h] with y down to clip space
+        static Affine2 ortho(float w, float h);
+    };
+
+    /// @brief Fixed capacity push/pop transform stack, never allocates. A push on a full
+    /// stack is counted instead, and the pop matching it only takes the count back, so
+    /// pushes and pops stay paired however deep the caller goes
+    template<size_t N>
+    class TransformStack
+    {
+        public:
+            TransformStack();
+
+            /// @brief Drop every level and the overflow count, and start again from m
+            void reset(const Affine2& m);
+
+            /// @brief Duplicate the current transform
+            /// @return false if the stack is full: the push is counted as an overflow and
+            /// the transform stays at the current level
+            bool push();
+
+            /// @brief Go back to the transform saved by the last push, or take back the
+            /// last overflowed push, which leaves the current transform as it is
+            /// @return false if there is nothing to pop
+            bool pop();
+
+            /// @brief Post multiply the current transform by m
+            void multiply(const Affine2& m);
+
+            const Affine2& current() const;
+            size_t depth() const;
+
+            /// @brief Pushes made on a full stack and not popped yet
+            size_t overflow() const;
+
+        private:
+            Affine2 stack[N];
+            size_t top = 0;
+            size_t overflowed = 0;
+    };
+
+
+    inline Affine2 Affine2::operator*(const Affine2& m) const
+    {
+        return {
+            a * m.a + c * m.b, b * m.a + d * m.b,
+            a * m.c + c * m.d, b * m.c + d * m.d,
+            a * m.tx + c * m.ty + tx, b * m.tx + d * m.ty + ty
+        };
+    }
+
+    inline Vector2 Affine2::apply(const Vector2& v) const
+    {
+        return { a * v.x + c * v.y + tx, b * v.x + d * v.y + ty };
+    }
+
+    inline Affine2 Affine2::inverse() const
+    {
+        const float det = a * d - b * c;
+        if(det == 0.0f)
+            return {};
+        const float id = 1.0f / det;
+        return {
+            d * id, -b * id,
+            -c * id, a * id,
+            (c * ty - d * tx) * id, (b * tx - a * ty) * id
+        };
+    }
+
+    inline void Affine2::toMat4(float out[16]) const
+    {
+        out[0] = a;   out[1] = b;   out[2] = 0.0f;  out[3] = 0.0f;
+        out[4] = c;   out[5] = d;   out[6] = 0.0f;  out[7] = 0.0f;
+        out[8] = 0.0f; out[9] = 0.0f; out[10] = 1.0f; out[11] = 0.0f;
+        out[12] = tx; out[13] = ty; out[14] = 0.0f; out[15] = 1.0f;
+    }
+
+    inline Affine2 Affine2::translation(float x, float y)
+    {
+        return { 1.0f, 0.0f, 0.0f, 1.0f, x, y };
+    }
+
+    inline Affine2 Affine2::scaling(float sx, float sy)
+    {
+        return { sx, 0.0f, 0.0f, sy, 0.0f, 0.0f };
+    }
+
+    inline Affine2 Affine2::rotation(float angle)
+    {
+        float r = angle * 3.1415f / 180;
+        float cs = std::cos(r), sn = std::sin(r);
+        return { cs, sn, -sn, cs, 0.0f, 0.0f };
+    }
+
+    inline Affine2 Affine2::ortho(float w, float h)
+    {
+        return { 2.0f / w, 0.0f, 0.0f, -2.0f / h, -1.0f, 1.0f };
+    }
+
+    template<size_t N>
+    inline TransformStack<N>::TransformStack()
+    {
+        static_assert(N > 0, "TransformStack needs at least one level");
+    }
+
+    template<size_t N>
+    inline void TransformStack<N>::reset(const Affine2& m)
+    {
+        top = 0;
+        overflowed = 0;
+        stack[0] = m;
+    }
+
+    template<size_t N>
+    inline bool TransformStack<N>::push()
+    {
+        if(top + 1 >= N) {
+            overflowed++;
+            return false;
+        }
+        stack[top + 1] = stack[top];
+        top++;
+        return true;
+    }
+
+    template<size_t N>
+    inline bool TransformStack<N>::pop()
+    {
+        if(overflowed > 0) {
+            overflowed--;
+            return true;
+        }
+        if(top == 0)
+            return false;
+        top--;
+        return true;
+    }
+
+    template<size_t N>
+    inline void TransformStack<N>::multiply(const Affine2& m)
+    {
+        stack[top] = stack[top] * m;
+    }
+
+    template<size_t N>
+    inline const Affine2& TransformStack<N>::current() const
+    {
+        return stack[top];
+    }
+
+    template<size_t N>
+    inline size_t TransformStack<N>::depth() const
+    {
+        return top;
+    }
+
+    template<size_t N>
+    inline size_t TransformStack<N>::overflow() const
+    {
+        return overflowed;
+    }
+}
+
+#endif
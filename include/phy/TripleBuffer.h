@@ -0,0 +1,88 @@
+/**
+ * Lock-free single producer / single consumer triple buffer. The producer
+ * always owns one buffer to write, the consumer always owns one buffer to
+ * read, and the third one is exchanged through a single atomic. Neither
+ * side ever waits for the other: the producer can publish faster than the
+ * consumer reads (older snapshots are simply skipped) and the consumer can
+ * keep reading the same snapshot while the producer is busy.
+ */
+#ifndef __BYTENOL_PCGA_TRIPLE_BUFFER_H__
+#define __BYTENOL_PCGA_TRIPLE_BUFFER_H__
+
+#include <atomic>
+#include <cstdint>
+
+namespace phy
+{
+    template<typename T>
+    class TripleBuffer
+    {
+        public:
+            /// @brief Buffer owned by the producer, fill it then call publish
+            T& writeBuffer();
+
+            /// @brief Hand the write buffer to the consumer and take the spare one back
+            void publish();
+
+            /// @brief Take the latest published buffer, if any
+            /// @return true if readBuffer now holds a snapshot newer than before
+            bool update();
+
+            /// @brief Buffer owned by the consumer, stays valid until the next update
+            const T& readBuffer() const;
+            T& readBuffer();
+
+        private:
+            static constexpr uint8_t indexMask = 0x3;
+            static constexpr uint8_t dirtyBit = 0x4;
+
+            T buffers[3];
+            uint8_t writeIndex = 0;
+            uint8_t readIndex = 1;
+
+            // index of the spare buffer, with dirtyBit set when it holds an unread snapshot
+            std::atomic<uint8_t> middle{ 2 };
+    };
+
+
+    template<typename T>
+    inline T& TripleBuffer<T>::writeBuffer()
+    {
+        return buffers[writeIndex];
+    }
+
+    template<typename T>
+    inline void TripleBuffer<T>::publish()
+    {
+        // release: the consumer must see every write made to the buffer
+        uint8_t previous = middle.exchange(writeIndex | dirtyBit, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    template<typename T>
+    inline bool TripleBuffer<T>::update()
+    {
+        if((middle.load(std::memory_order_relaxed) & dirtyBit) == 0)
+            return false;
+
+        uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    template<typename T>
+    inline const T& TripleBuffer<T>::readBuffer() const
+    {
+        return buffers[readIndex];
+    }
+
+    template<typename T>
+    inline T& TripleBuffer<T>::readBuffer()
+    {
+        return buffers[readIndex];
+    }
+
+} // namespace phy
+
+
+#endif
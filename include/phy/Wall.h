@@ -1,8 +1,8 @@
 #ifndef __BYTENOL_PCGA_WALL_H__
 #define __BYTENOL_PCGA_WALL_H__
 
-#include <SDL.h>
 #include "Vector.h"
+#include "DrawList.h"
 
 namespace phy {
 
@@ -11,14 +11,13 @@ namespace phy {
         Vector2 start;
         Vector2 end;
         
-        void render(SDL_Renderer* renderer) const;
+        void draw(DrawList& list) const;
     };
 
-    void Wall::render(SDL_Renderer *renderer) const
+    inline void Wall::draw(DrawList& list) const
     {
-        SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xff);
-        SDL_RenderDrawLineF(renderer, start.x, start.y, end.x, end.y);
+        list.line(start.x, start.y, end.x, end.y, 0x000000);
     }
 }
 
-#endif 
\ No newline at end of file
+#endif
@@ -0,0 +1,702 @@
+/**
+ * A world of rigid bodies stepped with a fixed pipeline: transforms,
+ * broadphase, narrowphase, islands, velocity solve and integration.
+ *
+ * Bodies connected through contacts form islands (union-find over the
+ * contact graph). An island whose bodies all stayed below the sleep
+ * velocities for sleepFrames steps is put to sleep: its bodies skip
+ * integration, transform updates and narrowphase until a contact with an
+ * awake body or a call to wake() / applyImpulse() wakes them again.
+ *
+ * The solver is warm started: a contact point lying close to a point of
+ * the same pair in the previous step starts from the impulses that point
+ * ended with, so the load of a stack carries over from step to step and
+ * resting piles come to rest, and then to sleep, instead of jittering.
+ *
+ * A ball moving further than its radius in a step could skip over a thin
+ * static body between two narrowphase tests, so it is swept against the
+ * static bodies around its path (Sweep.h) instead of integrated blindly.
+ *
+ * Given a JobSystem the transform update, the broadphase, the collision
+ * tests of the narrowphase and the integration run as parallel jobs; the
+ * islands and the sequential impulse solver stay on the calling thread.
+ * Results do not depend on the number of threads: every parallel phase
+ * produces its output in the order a single thread would.
+ */
+#ifndef __BYTENOL_PCGA_WORLD_H__
+#define __BYTENOL_PCGA_WORLD_H__
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <climits>
+#include <cstdint>
+#include <numbers>
+#include <algorithm>
+#include "Vector.h"
+#include "RigidBody.h"
+#include "Broadphase.h"
+#include "Narrowphase.h"
+#include "TimeOfImpact.h"
+#include "Sweep.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Stats.h"
+
+namespace phy
+{
+    struct Contact
+    {
+        unsigned int a;
+        unsigned int b;
+        Manifold manifold;
+
+        // solver state of each manifold point
+        float normalImpulse[2] = { 0.0f, 0.0f };
+        float tangentImpulse[2] = { 0.0f, 0.0f };
+        float velocityBias[2] = { 0.0f, 0.0f };
+    };
+
+    struct WorldMetrics
+    {
+        size_t awakeBodies = 0;
+        size_t sleepingBodies = 0;
+        size_t staticBodies = 0;
+        size_t islands = 0;         // awake islands built during the last step
+        size_t contacts = 0;
+    };
+
+    class World
+    {
+        public:
+            std::vector<RigidBody> bodies;
+
+            Vector2 gravity;
+            float restitution = 0.2f;
+            float restitutionThreshold = 30.0f; // slower impacts do not bounce, so resting contacts settle
+            float friction = 0.3f;
+            int solverIterations = 8;
+            bool warmStarting = true;
+            float warmStartDistance = 2.0f;     // farthest a point may move and keep its impulses
+
+            bool allowSleep = true;
+            float sleepVelocity = 2.0f;         // linear speed below which a body may sleep
+            float sleepAngularVelocity = 2.0f;  // degrees per second
+            int sleepFrames = 60;               // steps an island must stay slow before sleeping
+
+            /// @brief Add a body and compute its world space shape
+            /// @return index of the body
+            unsigned int add(const RigidBody& body);
+
+            /// @brief Advance the simulation by dt
+            void step(float dt);
+
+            /// @brief Size the pair and contact buffers for pairCount candidate pairs, so
+            /// steps below it never grow them, the other buffers follow the body count.
+            /// Call it after setJobSystem, the parallel narrowphase has buffers of its own
+            void reserve(size_t pairCount);
+
+            /// @brief Wake a body, its island follows on the next step
+            void wake(unsigned int body);
+
+            /// @brief Apply a linear impulse at the center of mass, waking the body
+            void applyImpulse(unsigned int body, const Vector2& impulse);
+
+            /// @brief Run the parallel phases of step() on jobs, nullptr steps on the calling
+            /// thread. The system must outlive the world or be replaced first.
+            void setJobSystem(JobSystem* jobs);
+            JobSystem* getJobSystem() const;
+
+            const std::vector<Contact>& getContacts() const;
+            const WorldMetrics& getMetrics() const;
+            const Broadphase& getBroadphase() const;
+
+            /// @brief Work counters and step time histogram, updated by every step
+            const Stats& getStats() const;
+            Stats& getStats();
+
+            /// @brief Shape of a body for the narrowphase, valid until its next transform update
+            Shape shapeOf(const RigidBody& body) const;
+
+            // the phases of step() in order, public so benchmarks can run and
+            // measure them one at a time. Only step() clears and merges the
+            // stats counters they add to
+            void updateTransforms();
+            void findPairs();
+            void narrowphase();
+            void updateIslands();
+            void integrateVelocities(float dt);
+            void solve();
+            void integratePositions(float dt);
+
+            const std::vector<BroadphasePair>& getPairs() const;
+
+        private:
+            void updateTransform(RigidBody& body, AABB& box);
+
+            /// @brief Move a ball by dt, bouncing off the static bodies its path crosses
+            void sweepCircle(RigidBody& body, float dt) const;
+
+            unsigned int findRoot(unsigned int i);
+
+            /// @brief Bytes reserved by the scratch buffers of the step
+            size_t scratchBytes() const;
+
+            Broadphase broadphase;
+            std::vector<AABB> bounds;
+            std::vector<BroadphasePair> pairs;
+            std::vector<Contact> contacts;
+            std::vector<Contact> previousContacts;  // of the last solve sorted by pair, they warm start the next one
+            std::vector<unsigned int> parent;
+            std::vector<int> islandCounter;
+            std::vector<char> islandAwake;
+            IntegrationScratch integration;
+            std::vector<Contact> candidates;        // narrowphase result of every pair, tested in parallel
+            std::vector<char> candidateState;       // per pair: not tested, touching or apart
+            JobSystem* jobs = nullptr;
+            WorldMetrics metrics;
+            Stats stats;
+    };
+
+
+    inline unsigned int World::add(const RigidBody& body)
+    {
+        bodies.push_back(body);
+        bounds.emplace_back();
+        updateTransform(bodies.back(), bounds.back());
+        return static_cast<unsigned int>(bodies.size() - 1);
+    }
+
+    inline void World::step(float dt)
+    {
+        PHY_PROFILE_ZONE("World::step");
+        const auto start = std::chrono::steady_clock::now();
+        const size_t scratch = scratchBytes();
+        stats.beginStep();
+
+        updateTransforms();
+        findPairs();
+        narrowphase();
+        updateIslands();
+        integrateVelocities(dt);
+        solve();
+        integratePositions(dt);
+
+        stats.local().add(Counter::BytesAllocated, std::max(scratchBytes(), scratch) - scratch);
+        stats.endStep(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    inline void World::reserve(size_t pairCount)
+    {
+        pairs.reserve(pairCount);
+        contacts.reserve(pairCount);
+        previousContacts.reserve(pairCount);
+        if(jobs) {
+            candidates.reserve(pairCount);
+            candidateState.reserve(pairCount);
+            broadphase.reserve(pairCount);
+        }
+    }
+
+    inline void World::wake(unsigned int body)
+    {
+        bodies[body].awake = true;
+        bodies[body].sleepCounter = 0;
+    }
+
+    inline void World::applyImpulse(unsigned int body, const Vector2& impulse)
+    {
+        auto& b = bodies[body];
+        b.vel += impulse * b.invMass();
+        wake(body);
+    }
+
+    inline void World::setJobSystem(JobSystem* jobs)
+    {
+        this->jobs = jobs;
+        stats.setThreads(jobs ? jobs->threads() : 1);
+    }
+
+    inline JobSystem* World::getJobSystem() const
+    {
+        return jobs;
+    }
+
+    inline const std::vector<Contact>& World::getContacts() const
+    {
+        return contacts;
+    }
+
+    inline const WorldMetrics& World::getMetrics() const
+    {
+        return metrics;
+    }
+
+    inline const Broadphase& World::getBroadphase() const
+    {
+        return broadphase;
+    }
+
+    inline const std::vector<BroadphasePair>& World::getPairs() const
+    {
+        return pairs;
+    }
+
+    inline const Stats& World::getStats() const
+    {
+        return stats;
+    }
+
+    inline Stats& World::getStats()
+    {
+        return stats;
+    }
+
+    inline size_t World::scratchBytes() const
+    {
+        return bounds.capacity() * sizeof(AABB) + pairs.capacity() * sizeof(BroadphasePair) +
+            (contacts.capacity() + previousContacts.capacity()) * sizeof(Contact) + parent.capacity() * sizeof(unsigned int) +
+            islandCounter.capacity() * sizeof(int) + islandAwake.capacity() +
+            integration.handled.capacity() + integration.group.capacity() * sizeof(size_t) +
+            (integration.va.capacity() + integration.vb.capacity()) * sizeof(Vector2) +
+            candidates.capacity() * sizeof(Contact) + candidateState.capacity();
+    }
+
+    inline Shape World::shapeOf(const RigidBody& body) const
+    {
+        if(body.vertices.empty()) {
+            Shape s;
+            s.type = ShapeType::Circle;
+            s.center = body.pos;
+            s.radius = body.radius;
+            return s;
+        }
+        return polygonShape(body.pos, body.transformed);
+    }
+
+    inline void World::updateTransform(RigidBody& body, AABB& box)
+    {
+        if(body.vertices.empty()) {
+            box.min = { body.pos.x - body.radius, body.pos.y - body.radius };
+            box.max = { body.pos.x + body.radius, body.pos.y + body.radius };
+            return;
+        }
+
+        transformVertices(body.vertices, body.pos, body.rotation, body.transformed);
+        box.min = { INFINITY, INFINITY };
+        box.max = { -INFINITY, -INFINITY };
+        for(const auto& v: body.transformed) {
+            box.min.x = std::min(box.min.x, v.x);
+            box.min.y = std::min(box.min.y, v.y);
+            box.max.x = std::max(box.max.x, v.x);
+            box.max.y = std::max(box.max.y, v.y);
+        }
+    }
+
+    inline void World::updateTransforms()
+    {
+        PHY_PROFILE_ZONE("World::transforms");
+        bounds.resize(bodies.size());
+        parallelFor(jobs, bodies.size(), [this](size_t begin, size_t end, unsigned int) {
+            for(size_t i = begin; i < end; i++)
+            {
+                auto& body = bodies[i];
+                if(body.awake && !body.isStatic())
+                    updateTransform(body, bounds[i]);
+            }
+        });
+        stats.local().add(Counter::Bodies, bodies.size());
+    }
+
+    inline void World::findPairs()
+    {
+        PHY_PROFILE_ZONE("World::broadphase");
+        broadphase.clear();
+        for(size_t i = 0; i < bodies.size(); i++)
+        {
+            Proxy proxy;
+            proxy.box = bounds[i];
+            proxy.body = static_cast<unsigned int>(i);
+            proxy.category = bodies[i].category;
+            proxy.mask = bodies[i].mask;
+            broadphase.add(proxy);
+        }
+        broadphase.findPairs(pairs, jobs);
+
+        auto& counters = stats.local();
+        counters.add(Counter::Proxies, bodies.size());
+        counters.add(Counter::CandidatePairs, pairs.size());
+    }
+
+    inline void World::narrowphase()
+    {
+        PHY_PROFILE_ZONE("World::narrowphase");
+        contacts.clear();
+
+        // nothing moves in a pair of sleeping or static bodies
+        auto moving = [this](const BroadphasePair& pair) {
+            const auto& a = bodies[pair.a];
+            const auto& b = bodies[pair.b];
+            return (a.awake && !a.isStatic()) || (b.awake && !b.isStatic());
+        };
+
+        enum : char { Untested = 0, Touching, Apart };
+        auto test = [this](const BroadphasePair& pair, Contact& contact, StepCounters& counters) {
+            contact = Contact{ pair.a, pair.b, {} };
+            bool touching = collide(shapeOf(bodies[pair.a]), shapeOf(bodies[pair.b]), contact.manifold);
+            counters.add(Counter::SatAxes, contact.manifold.axesTested);
+            if(!touching)
+                counters.add(Counter::EarlyOuts);
+            return touching ? Touching : Apart;
+        };
+
+        // the collision tests of the pairs moving when the phase starts run in
+        // parallel, bodies only wake below so nothing they read changes
+        if(jobs) {
+            candidates.resize(pairs.size());
+            candidateState.assign(pairs.size(), Untested);
+            jobs->parallelFor(pairs.size(), [&](size_t begin, size_t end, unsigned int thread) {
+                auto& counters = stats.local(thread);
+                for(size_t i = begin; i < end; i++)
+                    if(moving(pairs[i]))
+                        candidateState[i] = test(pairs[i], candidates[i], counters);
+            });
+        }
+
+        // in pair order, a pair of sleeping bodies is still tested once an
+        // earlier contact woke one of them, as a single thread would
+        auto& counters = stats.local();
+        Contact contact;
+        for(size_t i = 0; i < pairs.size(); i++)
+        {
+            const auto& pair = pairs[i];
+            char state = jobs ? candidateState[i] : static_cast<char>(Untested);
+            if(state == Untested) {
+                if(!moving(pair))
+                    continue;
+                state = test(pair, contact, counters);
+            } else if(state == Touching) {
+                contact = candidates[i];
+            }
+            if(state != Touching)
+                continue;
+
+            // an awake body touching a sleeping one wakes it
+            if(!bodies[pair.a].isStatic() && !bodies[pair.a].awake) wake(pair.a);
+            if(!bodies[pair.b].isStatic() && !bodies[pair.b].awake) wake(pair.b);
+            contacts.push_back(contact);
+        }
+        counters.add(Counter::Contacts, contacts.size());
+    }
+
+    inline unsigned int World::findRoot(unsigned int i)
+    {
+        while(parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    inline void World::updateIslands()
+    {
+        PHY_PROFILE_ZONE("World::islands");
+        const size_t n = bodies.size();
+        parent.resize(n);
+        islandCounter.assign(n, INT_MAX);
+        islandAwake.assign(n, 0);
+        for(size_t i = 0; i < n; i++)
+            parent[i] = static_cast<unsigned int>(i);
+
+        // static bodies do not connect islands
+        for(const auto& c: contacts)
+        {
+            if(bodies[c.a].isStatic() || bodies[c.b].isStatic())
+                continue;
+            unsigned int ra = findRoot(c.a);
+            unsigned int rb = findRoot(c.b);
+            if(ra != rb) parent[ra] = rb;
+        }
+
+        const float linear2 = sleepVelocity * sleepVelocity;
+
+        for(size_t i = 0; i < n; i++)
+        {
+            auto& body = bodies[i];
+            if(body.isStatic() || !body.awake)
+                continue;
+
+            bool slow = body.vel.dotProduct(body.vel) <= linear2 &&
+                std::abs(body.angVel) <= sleepAngularVelocity;
+            body.sleepCounter = slow ? body.sleepCounter + 1 : 0;
+
+            unsigned int root = findRoot(static_cast<unsigned int>(i));
+            islandCounter[root] = std::min(islandCounter[root], body.sleepCounter);
+            islandAwake[root] = 1;
+        }
+
+        metrics = WorldMetrics{};
+        metrics.contacts = contacts.size();
+        for(size_t i = 0; i < n; i++)
+            if(islandAwake[i] && findRoot(static_cast<unsigned int>(i)) == i)
+                metrics.islands++;
+
+        for(size_t i = 0; i < n; i++)
+        {
+            auto& body = bodies[i];
+            if(body.isStatic()) {
+                metrics.staticBodies++;
+                continue;
+            }
+
+            unsigned int root = findRoot(static_cast<unsigned int>(i));
+            if(islandAwake[root]) {
+                // the whole island sleeps or wakes together
+                if(allowSleep && islandCounter[root] >= sleepFrames) {
+                    body.awake = false;
+                    body.vel = Vector2{};
+                    body.angVel = 0.0f;
+                } else if(!body.awake) {
+                    wake(static_cast<unsigned int>(i));
+                }
+            }
+
+            if(body.awake) metrics.awakeBodies++;
+            else metrics.sleepingBodies++;
+        }
+    }
+
+    inline void World::integrateVelocities(float dt)
+    {
+        PHY_PROFILE_ZONE("World::integrateVelocities");
+        parallelFor(jobs, bodies.size(), [this, dt](size_t begin, size_t end, unsigned int) {
+            for(size_t i = begin; i < end; i++)
+            {
+                auto& body = bodies[i];
+                if(body.awake && !body.isStatic())
+                    body.vel += gravity * dt;
+            }
+        });
+    }
+
+    inline void World::solve()
+    {
+        PHY_PROFILE_ZONE("World::solve");
+        constexpr float toRadians = std::numbers::pi_v<float> / 180.0f;
+        constexpr float toDegrees = 180.0f / std::numbers::pi_v<float>;
+        auto cross = [](const Vector2& a, const Vector2& b) { return a.x * b.y - a.y * b.x; };
+
+        // relative velocity of b with respect to a at the contact point, angVel is in degrees
+        auto relativeVelocity = [](const RigidBody& a, const RigidBody& b, const Vector2& ra, const Vector2& rb) {
+            float wa = a.angVel * toRadians, wb = b.angVel * toRadians;
+            return b.vel + Vector2{ -wb * rb.y, wb * rb.x } - a.vel - Vector2{ -wa * ra.y, wa * ra.x };
+        };
+
+        // an island put to sleep this step keeps its contacts but must not move
+        auto asleep = [this](const Contact& c) {
+            const auto& a = bodies[c.a];
+            const auto& b = bodies[c.b];
+            return !(a.awake && !a.isStatic()) && !(b.awake && !b.isStatic());
+        };
+
+        auto pairKey = [](const Contact& c) { return (static_cast<uint64_t>(c.a) << 32) | c.b; };
+        auto previous = [&](const Contact& c) -> const Contact* {
+            auto it = std::lower_bound(previousContacts.begin(), previousContacts.end(), pairKey(c),
+                [&](const Contact& p, uint64_t key) { return pairKey(p) < key; });
+            return it != previousContacts.end() && pairKey(*it) == pairKey(c) ? &*it : nullptr;
+        };
+
+        // restitution is decided once from the approach speed before any impulse,
+        // the impulses start from the closest point of the pair in the last step
+        const float match2 = warmStartDistance * warmStartDistance;
+        for(auto& c: contacts)
+        {
+            if(asleep(c))
+                continue;
+            const auto& a = bodies[c.a];
+            const auto& b = bodies[c.b];
+            const Contact* old = warmStarting ? previous(c) : nullptr;
+            for(int p = 0; p < c.manifold.pointCount; p++)
+            {
+                c.normalImpulse[p] = 0.0f;
+                c.tangentImpulse[p] = 0.0f;
+                float vn = relativeVelocity(a, b, c.manifold.points[p] - a.pos, c.manifold.points[p] - b.pos)
+                    .dotProduct(c.manifold.normal);
+                c.velocityBias[p] = vn < -restitutionThreshold ? -restitution * vn : 0.0f;
+
+                float closest = match2;
+                for(int q = 0; old && q < old->manifold.pointCount; q++)
+                {
+                    Vector2 d = c.manifold.points[p] - old->manifold.points[q];
+                    if(d.dotProduct(d) <= closest) {
+                        closest = d.dotProduct(d);
+                        c.normalImpulse[p] = old->normalImpulse[q];
+                        c.tangentImpulse[p] = old->tangentImpulse[q];
+                    }
+                }
+            }
+        }
+
+        for(const auto& c: contacts)
+        {
+            if(asleep(c))
+                continue;
+            auto& a = bodies[c.a];
+            auto& b = bodies[c.b];
+            const Vector2 tangent{ -c.manifold.normal.y, c.manifold.normal.x };
+            for(int p = 0; p < c.manifold.pointCount; p++)
+            {
+                Vector2 impulse = c.manifold.normal * c.normalImpulse[p] + tangent * c.tangentImpulse[p];
+                a.vel -= impulse * a.invMass();
+                b.vel += impulse * b.invMass();
+                a.angVel -= cross(c.manifold.points[p] - a.pos, impulse) * a.invInertia() * toDegrees;
+                b.angVel += cross(c.manifold.points[p] - b.pos, impulse) * b.invInertia() * toDegrees;
+            }
+        }
+
+        // sequential impulses, accumulated per point and clamped so they only push
+        if(!contacts.empty())
+            stats.local().add(Counter::SolverIterations, solverIterations);
+        for(int it = 0; it < solverIterations; it++)
+        {
+            for(auto& c: contacts)
+            {
+                if(asleep(c))
+                    continue;
+                auto& a = bodies[c.a];
+                auto& b = bodies[c.b];
+                const auto& m = c.manifold;
+                const Vector2 tangent{ -m.normal.y, m.normal.x };
+                const float imA = a.invMass(), imB = b.invMass();
+                const float iiA = a.invInertia(), iiB = b.invInertia();
+
+                for(int p = 0; p < m.pointCount; p++)
+                {
+                    Vector2 ra = m.points[p] - a.pos;
+                    Vector2 rb = m.points[p] - b.pos;
+
+                    float rna = cross(ra, m.normal), rnb = cross(rb, m.normal);
+                    float kn = imA + imB + rna * rna * iiA + rnb * rnb * iiB;
+                    float rta = cross(ra, tangent), rtb = cross(rb, tangent);
+                    float kt = imA + imB + rta * rta * iiA + rtb * rtb * iiB;
+                    if(kn <= 0.0f || kt <= 0.0f)
+                        continue;
+
+                    float vn = relativeVelocity(a, b, ra, rb).dotProduct(m.normal);
+                    float jn = (c.velocityBias[p] - vn) / kn;
+                    float old = c.normalImpulse[p];
+                    c.normalImpulse[p] = std::max(old + jn, 0.0f);
+                    jn = c.normalImpulse[p] - old;
+
+                    Vector2 impulse = m.normal * jn;
+                    a.vel -= impulse * imA;
+                    b.vel += impulse * imB;
+                    a.angVel -= cross(ra, impulse) * iiA * toDegrees;
+                    b.angVel += cross(rb, impulse) * iiB * toDegrees;
+
+                    // coulomb friction bounded by the normal impulse of the point
+                    float vt = relativeVelocity(a, b, ra, rb).dotProduct(tangent);
+                    float jt = -vt / kt;
+                    float maxFriction = friction * c.normalImpulse[p];
+                    old = c.tangentImpulse[p];
+                    c.tangentImpulse[p] = std::clamp(old + jt, -maxFriction, maxFriction);
+                    jt = c.tangentImpulse[p] - old;
+
+                    impulse = tangent * jt;
+                    a.vel -= impulse * imA;
+                    b.vel += impulse * imB;
+                    a.angVel -= cross(ra, impulse) * iiA * toDegrees;
+                    b.angVel += cross(rb, impulse) * iiB * toDegrees;
+                }
+            }
+        }
+
+        // push overlapping bodies apart so they do not sink into each other
+        constexpr float slop = 0.05f;
+        constexpr float percent = 0.4f;
+        for(const auto& c: contacts)
+        {
+            if(asleep(c))
+                continue;
+            auto& a = bodies[c.a];
+            auto& b = bodies[c.b];
+            float sum = a.invMass() + b.invMass();
+            if(sum <= 0.0f) continue;
+            Vector2 correction = c.manifold.normal * (std::max(c.manifold.depth - slop, 0.0f) * percent / sum);
+            a.pos -= correction * a.invMass();
+            b.pos += correction * b.invMass();
+        }
+
+        previousContacts.assign(contacts.begin(), contacts.end());
+        std::sort(previousContacts.begin(), previousContacts.end(),
+            [&](const Contact& x, const Contact& y) { return pairKey(x) < pairKey(y); });
+    }
+
+    inline void World::integratePositions(float dt)
+    {
+        PHY_PROFILE_ZONE("World::integratePositions");
+        // bullets are sub-stepped against their neighbours first, everything else is
+        // independent: static bodies do not move, so balls can sweep against them
+        integrateBullets(bodies, dt, integration, restitution);
+        parallelFor(jobs, bodies.size(), [this, dt](size_t begin, size_t end, unsigned int) {
+            for(size_t i = begin; i < end; i++)
+            {
+                auto& body = bodies[i];
+                if(integration.handled[i] || !body.awake || body.isStatic())
+                    continue;
+                if(body.vertices.empty() && body.vel.dotProduct(body.vel) * dt * dt > body.radius * body.radius)
+                    sweepCircle(body, dt);
+                else
+                    advanceBody(body, dt);
+            }
+        });
+    }
+
+    inline void World::sweepCircle(RigidBody& body, float dt) const
+    {
+        // advanceBall against the static bodies the broadphase finds around each leg of the path
+        constexpr int maxIterations = 4;
+        Proxy self;
+        self.category = body.category;
+        self.mask = body.mask;
+
+        body.rotation += body.angVel * dt;
+        float remaining = dt;
+        for(int i = 0; i < maxIterations && remaining > 0.0f; i++)
+        {
+            const Vector2 motion = body.vel * remaining;
+            AABB path;
+            path.min = { std::min(body.pos.x, body.pos.x + motion.x) - body.radius,
+                std::min(body.pos.y, body.pos.y + motion.y) - body.radius };
+            path.max = { std::max(body.pos.x, body.pos.x + motion.x) + body.radius,
+                std::max(body.pos.y, body.pos.y + motion.y) + body.radius };
+
+            SweepHit hit;
+            bool collided = false;
+            broadphase.query(path, [&](const Proxy& p) {
+                if(bodies[p.body].isStatic() && shouldCollide(self, p))
+                    collided |= sweepCircleBody(body.pos, motion, body.radius, bodies[p.body], hit);
+            });
+
+            if(!collided) {
+                body.pos += motion;
+                return;
+            }
+
+            body.pos += motion * hit.toi + hit.normal * sweepSkin;
+
+            // the same bounce the solver gives a contact
+            float vn = body.vel.dotProduct(hit.normal);
+            if(vn < 0.0f) {
+                float e = vn < -restitutionThreshold ? restitution : 0.0f;
+                body.vel -= hit.normal * ((1.0f + e) * vn);
+            }
+            remaining -= remaining * hit.toi;
+        }
+        // whatever motion is left after the last impact is dropped, like advanceBall
+    }
+
+} // namespace phy
+
+
+#endif
@@ -1,7 +1,6 @@
 /**
  * @todo create geometry and material
  * @todo remove resetMatrix
- * @todo remove glm from deps
  * @todo make it an header only library
  */
 #ifndef __BYTENOL_PHYSICS_FOR_CPP_GAMES_ANIMATION_WITH_OPENGL_H__
@@ -10,18 +9,20 @@
 #include <memory>
 #include <string>
 #include <climits>
-#include <map>
 #include <vector>
 #include <cmath>
 #include <numbers>
 #include <iostream>
+#include <cstddef>
+#include <algorithm>
 
 #include "../../deps/glad/include/glad/glad.h"
 #include "../../deps/glfw-3.4/include/GLFW/glfw3.h"
 
-// GLM
-#include "../../deps/glm/glm/glm.hpp"
-#include "../../deps/glm/glm/ext.hpp"
+#include "Batch.h"
+#include "Transform.h"
+#include "DrawList.h"
+#include "Profiler.h"
 
 
 namespace phy {
@@ -77,7 +78,8 @@ namespace phy {
         Ball() = default;
         Ball(Vector pos, float r);
 
-        void draw(CanvasElementPtr& ctx);
+        /// @brief Record the ball, Canvas2d::submit or any other backend draws it
+        void draw(DrawList& list) const;
     };
 
 
@@ -90,6 +92,20 @@ namespace phy {
         ~Buffer();
     };
 
+    /// @brief The Batch.h draw paths on OpenGL, every call is counted like CountingApi counts it
+    struct GLApi: CountingApi
+    {
+        void useProgram(unsigned int program);
+        void uniformColor(int location, const float* rgba);
+        void uniformMatrix(int location, const float* m);
+        void bindBuffer(unsigned int buffer);
+        void bindVertexArray(unsigned int vao);
+        void streamBuffer(const void* data, size_t bytes, size_t capacity);
+        void vertexAttrib(unsigned int index, float x, float y, float z);
+        void drawIndexed(size_t indices, size_t instances);
+        void drawLines(size_t vertices);
+    };
+
     class Canvas2d {
         friend CanvasElementPtr createContext(const int& w, const int& h, const char* title);
 
@@ -98,31 +114,96 @@ namespace phy {
             const int& getWidth() const;
             const int& getHeight() const;
             void resetMatrix();
+
+            /// @brief Save the current transform, at most maxTransformDepth levels
+            /// @return false if the stack is full, the push still needs its popMatrix
+            bool pushMatrix();
+
+            /// @brief Restore the transform of the matching pushMatrix, a pushMatrix
+            /// that overflowed restores nothing
+            /// @return false if there was no pushMatrix to match
+            bool popMatrix();
+            void translate(float x, float y);
+            void scale(float sx, float sy);
+            void rotate(float angle);
+
             GLFWwindow* getWindow() const;
             void setFillColor(uint hex, int alpha = 1);
             void drawArc(float x, float y, float r, int startAngle = 0.0f, int endAngle = 0.0f, bool isFill = true);
+
+            /// @brief Queue a line in the current fill color, drawn by flush().
+            /// Like drawArc it goes through the current transform, so after resetMatrix()
+            /// the points are pixels; lines used to be drawn in clip space, ignoring the stack
             void drawLine(float x1, float y1, float x2, float y2);
+
+            /// @brief Queue a filled circle through the current transform, all queued circles are drawn by flush().
+            /// The radius is scaled by the area scale of the transform, skews and uneven scales do not make ellipses
+            void fillCircle(float x, float y, float r, uint hex, float alpha = 1.0f);
+
+            /// @brief Queue every command of a DrawList into the circle and line batches, through the current transform.
+            /// Outlines and polygons are queued as line segments, there is no filled polygon path
+            void submit(const DrawList& list);
+
+            /// @brief Pick how queued circles are drawn, SDF by default
+            void setCircleMode(CircleMode mode);
+
+            /// @brief Draw every queued circle with one instanced draw call
+            /// and every queued line with one more draw call
+            void flush();
+
+            const DrawCounters& getCounters() const;
+            void resetCounters();
             ~Canvas2d();
 
         private:
             Canvas2d(const int& w, const int& h);
             unsigned int createShader(GLenum type, const std::string& src);
+            unsigned int createProgram(const std::string& vertexSource, const std::string& fragmentSource);
             bool linkProgram();
             void initCircleBuffer();
-            void addMatrix(glm::mat4 m);
-            void initUniformLocation();
+            void initCircleBatch();
+            void initLineBatch();
+            void initSDFCircleBatch();
+            void flushCircles(const float projection[16]);
+            void flushLines(const float projection[16]);
+            void uploadMatrix();
+
+            /// @brief Current transform taken to the pixel space the batches are flushed in
+            Affine2 batchTransform() const;
+            void queueLine(const Affine2& m, float x1, float y1, float x2, float y2, uint hex, float alpha);
+            void queueCircle(const Affine2& m, float x, float y, float r, uint hex, float alpha);
             
             int width;
             int height;
             unsigned int shaderProgram;
+            unsigned int batchProgram;
+            unsigned int sdfProgram;
             std::string title;
             GLFWwindow* window = nullptr;
             Buffer circleGeometry, lineGeometry;
 
-            glm::mat4 mIdentity = glm::mat4(1.0f);
-            std::vector<glm::mat4> matrices;
+            // instanced circles: shares the vertices and indices of circleGeometry
+            Buffer circleInstances;
+            size_t instanceCapacity = 0;
+            CircleBatch circles;
 
-            std::map<std::string, int> uniformLocation;
+            // sdf circles: one quad per instance, reads the same instance buffer
+            Buffer sdfQuad, sdfInstances;
+            CircleMode circleMode = CircleMode::SDF;
+
+            // streamed lines: the whole vertex buffer is orphaned every flush
+            size_t lineCapacity = 0;
+            LineBatch lines;
+            uint fillHex = 0;
+            float fillAlpha = 1.0f;
+            GLApi gl;
+
+            static constexpr size_t maxTransformDepth = 32;
+            TransformStack<maxTransformDepth> transforms;
+
+            // uniform locations, resolved once when the programs are linked
+            enum Uniform { UniformFillColor, UniformMatrix, UniformBatchProjection, UniformSDFProjection, UniformCount };
+            int uniforms[UniformCount] = { -1, -1, -1, -1 };
     };
 
     Vector::Vector(float _x, float _y) {
@@ -191,10 +272,68 @@ namespace phy {
     }
 
 
-    void Ball::draw(CanvasElementPtr& ctx)
+    inline void Ball::draw(DrawList& list) const
+    {
+        list.circle(pos.x, pos.y, radius, fillColor);
+    }
+
+
+    inline void GLApi::useProgram(unsigned int program)
+    {
+        CountingApi::useProgram(program);
+        glUseProgram(program);
+    }
+
+    inline void GLApi::uniformColor(int location, const float* rgba)
+    {
+        CountingApi::uniformColor(location, rgba);
+        glUniform4f(location, rgba[0], rgba[1], rgba[2], rgba[3]);
+    }
+
+    inline void GLApi::uniformMatrix(int location, const float* m)
+    {
+        CountingApi::uniformMatrix(location, m);
+        glUniformMatrix4fv(location, 1, false, m);
+    }
+
+    inline void GLApi::bindBuffer(unsigned int buffer)
+    {
+        CountingApi::bindBuffer(buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    }
+
+    inline void GLApi::bindVertexArray(unsigned int vao)
+    {
+        CountingApi::bindVertexArray(vao);
+        glBindVertexArray(vao);
+    }
+
+    inline void GLApi::streamBuffer(const void* data, size_t bytes, size_t capacity)
     {
-        ctx->setFillColor(fillColor);
-        ctx->drawArc(pos.x, pos.y, radius);
+        CountingApi::streamBuffer(data, bytes, capacity);
+        glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+    }
+
+    inline void GLApi::vertexAttrib(unsigned int index, float x, float y, float z)
+    {
+        CountingApi::vertexAttrib(index, x, y, z);
+        glVertexAttrib3f(index, x, y, z);
+    }
+
+    inline void GLApi::drawIndexed(size_t indices, size_t instances)
+    {
+        CountingApi::drawIndexed(indices, instances);
+        if(instances == 1)
+            glDrawElements(GL_TRIANGLES, indices, GL_UNSIGNED_INT, (void*)(0));
+        else
+            glDrawElementsInstanced(GL_TRIANGLES, indices, GL_UNSIGNED_INT, (void*)(0), instances);
+    }
+
+    inline void GLApi::drawLines(size_t vertices)
+    {
+        CountingApi::drawLines(vertices);
+        glDrawArrays(GL_LINES, 0, vertices);
     }
 
  
@@ -216,8 +355,42 @@ namespace phy {
 
 
     inline void Canvas2d::resetMatrix() {
-        matrices.clear();
-        addMatrix(glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f));
+        transforms.reset(Affine2::ortho(static_cast<float>(width), static_cast<float>(height)));
+        uploadMatrix();
+    }
+
+    inline bool Canvas2d::pushMatrix()
+    {
+        if(transforms.push())
+            return true;
+        std::cerr << "Canvas2d: transform stack overflow" << std::endl;
+        return false;
+    }
+
+    inline bool Canvas2d::popMatrix()
+    {
+        if(!transforms.pop())
+            return false;
+        uploadMatrix();
+        return true;
+    }
+
+    inline void Canvas2d::translate(float x, float y)
+    {
+        transforms.multiply(Affine2::translation(x, y));
+        uploadMatrix();
+    }
+
+    inline void Canvas2d::scale(float sx, float sy)
+    {
+        transforms.multiply(Affine2::scaling(sx, sy));
+        uploadMatrix();
+    }
+
+    inline void Canvas2d::rotate(float angle)
+    {
+        transforms.multiply(Affine2::rotation(angle));
+        uploadMatrix();
     }
 
 
@@ -228,26 +401,120 @@ namespace phy {
 
     inline void Canvas2d::setFillColor(uint hex, int alpha)
     {
-        const int r = (hex >> 16) & 0xff;
-        const int g = (hex >> 8) & 0xff;
-        const int b = hex & 0xff;
-        glUniform4f(uniformLocation["fillColor"], r / 255, g / 255, b / 255, alpha);
+        uploadFillColor(gl, uniforms[UniformFillColor], hex, static_cast<float>(alpha));
+        fillHex = hex;
+        fillAlpha = alpha;
     }
 
     inline void Canvas2d::drawArc(float x, float y, float r, int startAngle, int endAngle, bool isFill)
     {
-        addMatrix(glm::translate(mIdentity, glm::vec3(x, y, 0.0f)) * glm::scale(mIdentity, glm::vec3(r, r, 0.0f)));
-        glBindVertexArray(circleGeometry.vao);
-        glDrawElements(GL_TRIANGLES, circleGeometry.indexLength, GL_UNSIGNED_INT, (void*)(0));
+        // the circle transform only lives in the uniform, the stack is left alone
+        float m[16];
+        (transforms.current() * Affine2{ r, 0.0f, 0.0f, r, x, y }).toMat4(m);
+        drawMeshCircle(gl, uniforms[UniformMatrix], m, circleGeometry.vao, circleGeometry.indexLength);
     }
 
     inline void Canvas2d::drawLine(float x1, float y1, float x2, float y2)
     {
-        glUniformMatrix4fv(uniformLocation["matrix"], 1, false, glm::value_ptr(mIdentity));
-        float data[] { x1, y1, x2, y2 };
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * 4, data);
-        glBindVertexArray(lineGeometry.vao);
-        glDrawArrays(GL_LINES, 0, 2);
+        queueLine(batchTransform(), x1, y1, x2, y2, fillHex, fillAlpha);
+    }
+
+    inline void Canvas2d::fillCircle(float x, float y, float r, uint hex, float alpha)
+    {
+        queueCircle(batchTransform(), x, y, r, hex, alpha);
+    }
+
+    inline void Canvas2d::submit(const DrawList& list)
+    {
+        PHY_PROFILE_ZONE("Canvas2d::submit");
+        const Affine2 m = batchTransform();
+        const auto& vertices = list.getVertices();
+        for(const auto& c: list.getCommands())
+        {
+            switch(c.type)
+            {
+                case DrawPrimitive::Circle: queueCircle(m, c.x1, c.y1, c.x2, c.color, c.alpha); break;
+                case DrawPrimitive::Line: queueLine(m, c.x1, c.y1, c.x2, c.y2, c.color, c.alpha); break;
+                case DrawPrimitive::Polygon:
+                    for(uint32_t i = 0; i < c.count; i++) {
+                        const auto& v1 = vertices[c.first + i];
+                        const auto& v2 = vertices[c.first + (i + 1) % c.count];
+                        queueLine(m, v1.x, v1.y, v2.x, v2.y, c.color, c.alpha);
+                    }
+                    break;
+                case DrawPrimitive::CircleOutline: {
+                    const int segments = std::clamp((int)c.x2, 8, 64);
+                    for(int i = 0; i < segments; i++) {
+                        float a1 = i * 2 * std::numbers::pi_v<float> / segments;
+                        float a2 = (i + 1) * 2 * std::numbers::pi_v<float> / segments;
+                        queueLine(m, c.x1 + std::cos(a1) * c.x2, c.y1 + std::sin(a1) * c.x2,
+                            c.x1 + std::cos(a2) * c.x2, c.y1 + std::sin(a2) * c.x2, c.color, c.alpha);
+                    }
+                    break;
+                }
+                default: break;
+            }
+        }
+    }
+
+    inline void Canvas2d::setCircleMode(CircleMode mode)
+    {
+        circleMode = mode;
+    }
+
+    inline void Canvas2d::flush()
+    {
+        PHY_PROFILE_ZONE("Canvas2d::flush");
+        if(circles.empty() && lines.empty())
+            return;
+
+        float projection[16];
+        Affine2::ortho(static_cast<float>(width), static_cast<float>(height)).toMat4(projection);
+
+        flushCircles(projection);
+        flushLines(projection);
+        gl.useProgram(shaderProgram);
+    }
+
+    inline void Canvas2d::flushCircles(const float projection[16])
+    {
+        PHY_PROFILE_ZONE("Canvas2d::flushCircles");
+        if(circles.empty())
+            return;
+
+        const bool sdf = circleMode == CircleMode::SDF;
+        const Buffer& geometry = sdf ? sdfInstances : circleInstances;
+        BatchTarget target;
+        target.program = sdf ? sdfProgram : batchProgram;
+        target.projection = uniforms[sdf ? UniformSDFProjection : UniformBatchProjection];
+        target.buffer = circleInstances.vbo;
+        target.vao = geometry.vao;
+        target.indexCount = geometry.indexLength;
+        flushCircleBatch(gl, target, projection, circles, instanceCapacity);
+    }
+
+    inline void Canvas2d::flushLines(const float projection[16])
+    {
+        PHY_PROFILE_ZONE("Canvas2d::flushLines");
+        if(lines.empty())
+            return;
+
+        BatchTarget target;
+        target.program = batchProgram;
+        target.projection = uniforms[UniformBatchProjection];
+        target.buffer = lineGeometry.vbo;
+        target.vao = lineGeometry.vao;
+        flushLineBatch(gl, target, projection, lines, lineCapacity);
+    }
+
+    inline const DrawCounters& Canvas2d::getCounters() const
+    {
+        return gl.counters;
+    }
+
+    inline void Canvas2d::resetCounters()
+    {
+        gl.counters = DrawCounters{};
     }
 
     inline Canvas2d::~Canvas2d()
@@ -282,6 +549,37 @@ namespace phy {
     }
 
 
+    inline unsigned int Canvas2d::createProgram(const std::string &vertexSource, const std::string &fragmentSource)
+    {
+        auto vShader = createShader(GL_VERTEX_SHADER, vertexSource);
+        auto fShader = createShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+        if(vShader == UINT_MAX || fShader == UINT_MAX) {
+            return UINT_MAX;
+        }
+
+        unsigned int program = glCreateProgram();
+        glAttachShader(program, vShader);
+        glAttachShader(program, fShader);
+        glLinkProgram(program);
+
+        glDeleteShader(vShader);
+        glDeleteShader(fShader);
+
+        int status;
+        char infoLog[512];
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if(!status) {
+            glGetProgramInfoLog(program, 512, nullptr, infoLog);
+            std::cerr << (std::string("ProgramError: ") + infoLog) << std::endl;
+            glDeleteProgram(program);
+            return UINT_MAX;
+        }
+
+        return program;
+    }
+
+
     inline bool Canvas2d::linkProgram()
     {
         const std::string vertexShaderSource = R"(#version 330 core
@@ -304,30 +602,76 @@ namespace phy {
             outColor = fillColor;
         })";
 
-        auto vShader = createShader(GL_VERTEX_SHADER, vertexShaderSource);
-        auto fShader = createShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+        // circles drawn by flush(): one instance per circle
+        const std::string batchVertexShaderSource = R"(#version 330 core
+        layout (location=0) in vec2 position;
+        layout (location=1) in vec3 instance;
+        layout (location=2) in vec4 color;
 
-        if(vShader == UINT_MAX || fShader == UINT_MAX) {
-            return false;
-        }
+        uniform mat4 projection;
 
-        shaderProgram = glCreateProgram();
-        glAttachShader(shaderProgram, vShader);
-        glAttachShader(shaderProgram, fShader);
-        glLinkProgram(shaderProgram);
+        out vec4 vColor;
 
-        glDeleteShader(vShader);
-        glDeleteShader(fShader);
+        void main() {
+            vColor = color;
+            gl_Position = projection * vec4(position * instance.z + instance.xy, 0.0f, 1.0f);
+        })";
 
-        int status;
-        char infoLog[512];
-        glGetProgramiv(shaderProgram, GL_LINK_STATUS, &status);
-        if(!status) {
-            glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-            std::cerr << (std::string("ProgramError: ") + infoLog) << std::endl;
+        const std::string batchFragmentShaderSource = R"(#version 330 core
+        precision highp float;
+        in vec4 vColor;
+
+        out vec4 outColor;
+
+        void main() {
+            outColor = vColor;
+        })";
+
+        // sdf circles: the unit quad is grown by one pixel for the antialiased edge
+        const std::string sdfVertexShaderSource = R"(#version 330 core
+        layout (location=0) in vec2 position;
+        layout (location=1) in vec3 instance;
+        layout (location=2) in vec4 color;
+
+        uniform mat4 projection;
+
+        out vec4 vColor;
+        out vec2 vLocal;
+        out float vRadius;
+
+        void main() {
+            vColor = color;
+            vRadius = instance.z;
+            vLocal = position * (instance.z + 1.0f);
+            gl_Position = projection * vec4(vLocal + instance.xy, 0.0f, 1.0f);
+        })";
+
+        const std::string sdfFragmentShaderSource = R"(#version 330 core
+        precision highp float;
+        in vec4 vColor;
+        in vec2 vLocal;
+        in float vRadius;
+
+        out vec4 outColor;
+
+        void main() {
+            float d = length(vLocal) - vRadius;
+            float coverage = clamp(0.5f - d / max(fwidth(d), 1e-4f), 0.0f, 1.0f);
+            if(coverage <= 0.0f)
+                discard;
+            outColor = vec4(vColor.rgb, vColor.a * coverage);
+        })";
+
+        shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
+        batchProgram = createProgram(batchVertexShaderSource, batchFragmentShaderSource);
+        sdfProgram = createProgram(sdfVertexShaderSource, sdfFragmentShaderSource);
+        if(shaderProgram == UINT_MAX || batchProgram == UINT_MAX || sdfProgram == UINT_MAX)
             return false;
-        }
 
+        uniforms[UniformFillColor] = glGetUniformLocation(shaderProgram, "fillColor");
+        uniforms[UniformMatrix] = glGetUniformLocation(shaderProgram, "matrix");
+        uniforms[UniformBatchProjection] = glGetUniformLocation(batchProgram, "projection");
+        uniforms[UniformSDFProjection] = glGetUniformLocation(sdfProgram, "projection");
         return true;
     }
 
@@ -336,7 +680,7 @@ namespace phy {
     {
         std::vector<float> position{ 0.0f, 0.0f };
 
-        int step = 10;
+        int step = 360 / circleSegments;
         for(int i = 0; i <= 360; i += step) {
             float a1 = i * std::numbers::pi / 180;
             position.push_back(std::cos(a1));
@@ -373,35 +717,123 @@ namespace phy {
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
+    }
+
+
+    inline void Canvas2d::initCircleBatch()
+    {
+        glGenVertexArrays(1, &circleInstances.vao);
+        glGenBuffers(1, &circleInstances.vbo);
+        circleInstances.ibo = 0;
+        circleInstances.indexLength = circleGeometry.indexLength;
+
+        glBindVertexArray(circleInstances.vao);
+
+        // per vertex: the unit circle mesh
+        glBindBuffer(GL_ARRAY_BUFFER, circleGeometry.vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, false, 0, (void*)(0));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, circleGeometry.ibo);
+
+        // per instance: center, radius and color
+        glBindBuffer(GL_ARRAY_BUFFER, circleInstances.vbo);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(CircleInstance), (void*)(offsetof(CircleInstance, x)));
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, false, sizeof(CircleInstance), (void*)(offsetof(CircleInstance, r)));
+        glVertexAttribDivisor(2, 1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+
+    inline void Canvas2d::initSDFCircleBatch()
+    {
+        const float quad[] = { -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f };
+        const int indices[] = { 0, 1, 2, 0, 2, 3 };
+
+        // sdfQuad only owns the buffers, sdfInstances owns the vertex layout
+        sdfQuad.vao = 0;
+        glGenBuffers(1, &sdfQuad.vbo);
+        glGenBuffers(1, &sdfQuad.ibo);
+        sdfQuad.indexLength = circleIndexCount(CircleMode::SDF);
+
+        glBindBuffer(GL_ARRAY_BUFFER, sdfQuad.vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+        glGenVertexArrays(1, &sdfInstances.vao);
+        sdfInstances.vbo = 0;
+        sdfInstances.ibo = 0;
+        sdfInstances.indexLength = sdfQuad.indexLength;
+
+        glBindVertexArray(sdfInstances.vao);
+
+        glBindBuffer(GL_ARRAY_BUFFER, sdfQuad.vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, false, 0, (void*)(0));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sdfQuad.ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+        // same instance buffer as the mesh path
+        glBindBuffer(GL_ARRAY_BUFFER, circleInstances.vbo);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(CircleInstance), (void*)(offsetof(CircleInstance, x)));
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, false, sizeof(CircleInstance), (void*)(offsetof(CircleInstance, r)));
+        glVertexAttribDivisor(2, 1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 
-        // @todo line buffer stuff shouldnt be here
+
+    inline void Canvas2d::initLineBatch()
+    {
         glGenVertexArrays(1, &lineGeometry.vao);
         glGenBuffers(1, &lineGeometry.vbo);
-        glGenBuffers(1, &lineGeometry.ibo);
+        lineGeometry.ibo = 0;
+        lineGeometry.indexLength = 0;
 
         glBindVertexArray(lineGeometry.vao);
 
         glBindBuffer(GL_ARRAY_BUFFER, lineGeometry.vbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 4, nullptr, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, false, 0, (void*)(0));
+        glVertexAttribPointer(0, 2, GL_FLOAT, false, sizeof(LineVertex), (void*)(offsetof(LineVertex, x)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, false, sizeof(LineVertex), (void*)(offsetof(LineVertex, r)));
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
 
-    inline void Canvas2d::addMatrix(glm::mat4 m) {
-        auto t = matrices.empty() ? mIdentity : matrices.back();
-        matrices.push_back(t * m);
-        glUniformMatrix4fv(uniformLocation["matrix"], 1, false, glm::value_ptr(matrices.back()));
+    inline void Canvas2d::uploadMatrix()
+    {
+        float m[16];
+        transforms.current().toMat4(m);
+        gl.uniformMatrix(uniforms[UniformMatrix], m);
     }
 
+    inline Affine2 Canvas2d::batchTransform() const
+    {
+        // flush() projects the batches with ortho, undo it from the current transform
+        return Affine2::ortho(static_cast<float>(width), static_cast<float>(height)).inverse() * transforms.current();
+    }
+
+    inline void Canvas2d::queueLine(const Affine2& m, float x1, float y1, float x2, float y2, uint hex, float alpha)
+    {
+        const Vector2 p1 = m.apply({ x1, y1 });
+        const Vector2 p2 = m.apply({ x2, y2 });
+        lines.add(p1.x, p1.y, p2.x, p2.y, hex, alpha);
+    }
 
-    inline void Canvas2d::initUniformLocation()
+    inline void Canvas2d::queueCircle(const Affine2& m, float x, float y, float r, uint hex, float alpha)
     {
-        uniformLocation["fillColor"] = glGetUniformLocation(shaderProgram, "fillColor");
-        uniformLocation["matrix"] = glGetUniformLocation(shaderProgram, "matrix");
+        const Vector2 p = m.apply({ x, y });
+        circles.add(p.x, p.y, r * std::sqrt(std::abs(m.a * m.d - m.b * m.c)), hex, alpha);
     }
 
     CanvasElementPtr createContext(const int& w, const int& h, const char* title) 
@@ -438,9 +870,14 @@ namespace phy {
         }
 
         glViewport(0, 0, w, h);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glUseProgram(cnv->shaderProgram);
-        cnv->initUniformLocation();
+        cnv->resetMatrix();
         cnv->initCircleBuffer();
+        cnv->initCircleBatch();
+        cnv->initSDFCircleBatch();
+        cnv->initLineBatch();
         
         return cnv;
 
@@ -6,13 +6,38 @@
  * This file shows the implementation of the seperating axis theorem, A 
  * common collision detection techniques that works for any convex polygons
  * and quadrilaterals.
+ * 
+ * The simulation runs at a fixed step on its own thread (when built with
+ * -pthread) and publishes snapshots through a triple buffer, the render
+ * thread interpolates between the last two so vsync never stalls physics.
+ * There the transforms and the collision tests of a step are also split
+ * over a JobSystem, leaving one core to the render thread.
+ * 
+ * Every snapshot carries the broadphase its step found the colliding pairs
+ * with, built from boxes covering each polygon over the whole step. A
+ * Camera2D pans (arrow keys) and zooms (mouse wheel) the view, and the
+ * render thread only blends and submits the polygons that broadphase
+ * returns for the visible box.
+ * 
+ * Built with PHY_ENABLE_PROFILER, P prints the time spent in every zone
+ * over the last second.
  */
 #include <iostream>
 #include <chrono>
-#include <SDL/SDL.h>
+#include <span>
+#include <SDL.h>
 #include <random>
+#include <atomic>
+#include <algorithm>
+#include <thread>
 #include <emscripten/emscripten.h>
 #include <phy/Vector.h>
+#include <phy/TripleBuffer.h>
+#include <phy/SAT.h>
+#include <phy/Broadphase.h>
+#include <phy/Camera.h>
+#include <phy/JobSystem.h>
+#include <phy/Profiler.h>
 
 using namespace phy;
 
@@ -44,14 +69,15 @@ struct Polygon
     // original vertex data without any transformation
     std::vector<Vector2> vertices;  
 
-    // transformed vertex data: always get updated in every frame
-    std::vector<Vector2> transformed;   
+    // transformed vertex data: a view into simulationPool, updated in every step
+    std::span<Vector2> transformed;
+    size_t first = 0;   // offset of the polygon in both vertex pools
+    size_t fanFirst = 0;    // offset of its triangles in fanIndices
 
     Polygon() = default;
     Polygon(const std::vector<Vector2>& vertices)
     {
         this->vertices = vertices;
-        this->transformed = vertices;
     }
 };
 
@@ -74,16 +100,91 @@ void render(Canvas& cnv);
 void update(float dt, Canvas& cnv);
 
 
+/// @brief Lay the transformed vertices of every polygon out in one flat array, 
+/// each polygon followed by its first vertex again so its outline is a closed strip
+void buildVertexPool();
+
+
+/// @brief Run every fixed step due since the last call and publish a snapshot after each
+void advanceSimulation();
+
+
+/// @brief Body of the simulation thread, only used with pthreads
+void simulationThread();
+
+
+/// @brief Blend the visible polygons of the last snapshot between the two poses
+/// of its step and write their screen space vertices into the render vertex pool
+void interpolate();
+
+
 /// @brief Carry out seperating axis theorem algorithms on polygons
 /// @param polygon The polygon to check 
 /// @param polygon2 The potential polygon it will collide with
 /// @return true if there is any collision
 bool sat_collision(Polygon& polygon, Polygon& polygon2);
 
-decltype(std::chrono::high_resolution_clock::now()) lastTime; 
+using Clock = std::chrono::steady_clock;
+
+/// @brief What the render thread needs of a polygon
+struct PolygonState
+{
+    Vector2 pos;
+    float rotation = 0.0f;
+    Uint8 blue = 255;
+};
+
+/// @brief Immutable state of the simulation after a step
+struct Snapshot
+{
+    double time = 0.0;      // seconds since start when the step finished
+    std::vector<PolygonState> before;   // poses at the start of the step
+    std::vector<PolygonState> polygons;
+
+    // boxes over the whole step, sorted by the pair search of the step
+    Broadphase broadphase;
+};
 
+
+/// @brief Find the pairs of the step through the broadphase of the snapshot and
+/// run the SAT test on them, the first polygon of a colliding pair turns red
+void collide(Snapshot& snapshot);
+
+// simulation thread state
+const double simStep = 1.0 / 120.0;
+const float timeScale = 10.0f;  // the old ns * 10e-9 factor ran the demo at 10x real time, keep that pace
+Clock::time_point startTime;
+Clock::time_point lastTime;
+double accumulator = 0.0;
 std::vector<Polygon> polygons;
+std::vector<Vector2> simulationPool;
 int W, H;
+JobSystem* jobs = nullptr;     // owned by the simulation thread, none without pthreads
+
+TripleBuffer<Snapshot> snapshots;
+
+// input from the render thread, consumed by the next step
+std::atomic<float> mouseX{ -1.0f }, mouseY{ -1.0f };
+std::atomic<int> rotateRequests{ 0 };
+
+// simulation thread pair search
+std::vector<BroadphasePair> pairs;
+std::vector<Uint8> pairHits;
+
+// render thread state
+Camera2D camera;
+std::vector<unsigned int> visible;
+std::vector<int> visibleIndices;
+Vector2 mouseScreen;
+
+// flat vertex data of every polygon, read directly by the renderer
+std::vector<Vector2> transformedPool;
+std::vector<SDL_Color> colorPool;
+std::vector<int> fanIndices;
+
+// filled polygons go out in a single SDL_RenderGeometryRaw call,
+// outlines need one SDL_RenderDrawLinesF per polygon
+bool fillPolygons = false;
 
 
 // The functions inside this block are exported
@@ -97,6 +198,9 @@ extern "C"
             return -1;
         }
         init(canvas);
+#ifdef __EMSCRIPTEN_PTHREADS__
+        std::thread(simulationThread).detach();
+#endif
         emscripten_set_main_loop(mainLoop, 0, 1);
         return 0;
     }
@@ -109,10 +213,9 @@ extern "C"
     }
 }
 
-void makePolygon(int amount)
+void makePolygon(int amount, unsigned int seed)
 {
-    std::random_device rd;
-    std::mt19937 eng(rd());
+    std::mt19937 eng(seed);
 
     auto randRange = [&eng](int min, int max) {
         std::uniform_int_distribution<> distr(min, max);
@@ -121,18 +224,9 @@ void makePolygon(int amount)
 
     for(int i=0; i < amount; i++)
     {
-        int sides = randRange(3, 6);
-        int step = 360 / sides;
-
-        float radius = randRange(5, 50);
-
-        // polar coordinates
-        std::vector<Vector2> vertices;
-        for(int j = 0; j < 360; j += step)
-        {
-            float angle = j * 3.14159f / 180;
-            vertices.push_back({ std::cos(angle) * radius, std::sin(angle) * radius });
-        }
+        int sides;
+        float radius;
+        auto vertices = randomPolygon(eng, sides, radius);
 
         Polygon polygon{ vertices };
         polygon.radius = radius;
@@ -150,128 +244,279 @@ void makePolygon(int amount)
 
 void init(Canvas& cnv)
 {
-    makePolygon(25);
+    makePolygon(25, 2024);
+    buildVertexPool();
     polygons[1].vel = Vector2(0, 0);    // mouse polygon
     int isFullScreen;
     emscripten_get_canvas_size(&W, &H, &isFullScreen);
-    lastTime = std::chrono::high_resolution_clock::now();
+    startTime = lastTime = Clock::now();
+    camera = Camera2D(W, H);
 }
 
 
 void update(float dt, Canvas& cnv)
 {
     // transform the whole polygon
-    for(auto& polygon: polygons)
-    {
-        polygon.pos += polygon.vel * dt;
-        for(int i = 0; i < polygon.vertices.size(); i++)
-            polygon.transformed[i] = polygon.pos + polygon.vertices[i].rotate(polygon.rotation);
-    }
-
-    for(auto polygon = polygons.begin(); polygon != polygons.end(); polygon++)
-    {
-        polygon->color.b = 255;
-
-        // wall boundary check
-        if(polygon->pos.x - polygon->radius <= 0) {
-            polygon->pos.x = polygon->radius;
-            polygon->vel.x *= -1;
-        } else if(polygon->pos.x + polygon->radius >= W) {
-            polygon->pos.x = W - polygon->radius;
-            polygon->vel.x *= -1;
+    parallelFor(jobs, polygons.size(), [dt](size_t begin, size_t end, unsigned int) {
+        for(size_t p = begin; p < end; p++)
+        {
+            auto& polygon = polygons[p];
+            polygon.pos += polygon.vel * dt;
+            for(int i = 0; i < polygon.vertices.size(); i++)
+                polygon.transformed[i] = polygon.pos + polygon.vertices[i].rotate(polygon.rotation);
         }
+    });
 
-        if(polygon->pos.y - polygon->radius <= 0) {
-            polygon->pos.y = polygon->radius;
-            polygon->vel.y *= -1;
-        } else if(polygon->pos.y + polygon->radius >= H) {
-            polygon->pos.y = H - polygon->radius;
-            polygon->vel.y *= -1;
+    parallelFor(jobs, polygons.size(), [](size_t begin, size_t end, unsigned int) {
+        for(auto polygon = polygons.begin() + begin; polygon != polygons.begin() + end; polygon++)
+        {
+            polygon->color.b = 255;
+
+            // wall boundary check
+            if(polygon->pos.x - polygon->radius <= 0) {
+                polygon->pos.x = polygon->radius;
+                polygon->vel.x *= -1;
+            } else if(polygon->pos.x + polygon->radius >= W) {
+                polygon->pos.x = W - polygon->radius;
+                polygon->vel.x *= -1;
+            }
+
+            if(polygon->pos.y - polygon->radius <= 0) {
+                polygon->pos.y = polygon->radius;
+                polygon->vel.y *= -1;
+            } else if(polygon->pos.y + polygon->radius >= H) {
+                polygon->pos.y = H - polygon->radius;
+                polygon->vel.y *= -1;
+            }
         }
+    });
+
+}
 
-        // check for sat collision
-        for(auto polygon2 = polygon + 1; polygon2 != polygons.end(); polygon2++)
-            if(sat_collision(*polygon, *polygon2))
-                polygon->color.b = 0;
-    }
 
+void collide(Snapshot& snapshot)
+{
+    // the box holds the vertices tested below and the bounding circle at
+    // both poses, so it bounds the polygon at every pose the render blends
+    snapshot.broadphase.clear();
+    for(size_t i = 0; i < polygons.size(); i++)
+    {
+        const auto& polygon = polygons[i];
+        const Vector2 r{ polygon.radius, polygon.radius };
+        const Vector2 a = snapshot.before[i].pos, b = polygon.pos;
+        Proxy proxy;
+        proxy.box = { Vector2{ std::min(a.x, b.x), std::min(a.y, b.y) } - r, Vector2{ std::max(a.x, b.x), std::max(a.y, b.y) } + r };
+        for(const auto& v: polygon.transformed) {
+            proxy.box.min = { std::min(proxy.box.min.x, v.x), std::min(proxy.box.min.y, v.y) };
+            proxy.box.max = { std::max(proxy.box.max.x, v.x), std::max(proxy.box.max.y, v.y) };
+        }
+        proxy.body = static_cast<unsigned int>(i);
+        snapshot.broadphase.add(proxy);
+    }
+    snapshot.broadphase.findPairs(pairs, jobs);
+
+    // a pair only reads the transformed vertices, the colors are set after
+    pairHits.resize(pairs.size());
+    parallelFor(jobs, pairs.size(), [](size_t begin, size_t end, unsigned int) {
+        for(size_t k = begin; k < end; k++)
+            pairHits[k] = sat_collision(polygons[pairs[k].a], polygons[pairs[k].b]);
+    });
+
+    for(size_t k = 0; k < pairs.size(); k++)
+        if(pairHits[k])
+            polygons[std::min(pairs[k].a, pairs[k].b)].color.b = 0;
 }
 
 
 bool sat_collision(Polygon& polygon, Polygon& polygon2)
 {
-    Polygon* poly1 = &polygon;
-    Polygon* poly2 = &polygon2;
-    
-    for(int i = 0; i < 2; i++)
+    return satCollision(polygon.transformed, polygon2.transformed);
+}
+
+
+void buildVertexPool()
+{
+    size_t count = 0;
+    for(auto& polygon: polygons)
+        count += polygon.vertices.size() + 1;
+
+    simulationPool.assign(count, Vector2{});
+    transformedPool.assign(count, Vector2{});
+    colorPool.assign(count, SDL_Color{ 0, 0, 0, 255 });
+    fanIndices.clear();
+
+    size_t first = 0;
+    for(auto& polygon: polygons)
     {
-        if(i > 0)
+        const size_t n = polygon.vertices.size();
+        polygon.first = first;
+        polygon.fanFirst = fanIndices.size();
+        polygon.transformed = std::span<Vector2>(simulationPool.data() + first, n);
+
+        for(size_t k = 1; k + 1 < n; k++)
         {
-            poly1 = &polygon2;
-            poly2 = &polygon;
+            fanIndices.push_back(first);
+            fanIndices.push_back(first + k);
+            fanIndices.push_back(first + k + 1);
         }
+        first += n + 1;
+    }
+}
 
-        for(int i = 0; i < poly1->transformed.size(); i++)
-        {
-            int inext = (i + 1) % poly1->transformed.size();
-            auto p1 = poly1->transformed[i];
-            auto p2 = poly1->transformed[inext];
-            auto vDir = p2 - p1;
-            auto normal = Vector2{ vDir.y, -vDir.x }.normalize();
-
-            float min_1 = INFINITY, max_1 = -INFINITY;
-            for(auto it = poly1->transformed.begin(); it != poly1->transformed.end(); it++)
-            {
-                float dp = it->dotProduct(normal);
-                min_1 = std::min(min_1, dp);
-                max_1 = std::max(max_1, dp);
-            }
 
-            float min_2 = INFINITY, max_2 = -INFINITY;
-            for(auto it = poly2->transformed.begin(); it != poly2->transformed.end(); it++)
-            {
-                float dp = it->dotProduct(normal);
-                min_2 = std::min(min_2, dp);
-                max_2 = std::max(max_2, dp);
-            }
+void advanceSimulation()
+{
+    auto now = Clock::now();
+    accumulator += std::chrono::duration<double>(now - lastTime).count();
+    lastTime = now;
 
-            if(!(min_1 <= max_2 && min_2 <= max_1))
-                return false;
+    // never try to catch up more than a few steps after a long stall
+    accumulator = std::min(accumulator, simStep * 8);
+    while(accumulator >= simStep)
+    {
+        float x = mouseX.load(std::memory_order_relaxed);
+        float y = mouseY.load(std::memory_order_relaxed);
+        if(x >= 0.0f) {
+            polygons[1].pos.x = x;
+            polygons[1].pos.y = y;
         }
+        Snapshot& snapshot = snapshots.writeBuffer();
+        snapshot.before.resize(polygons.size());
+        for(size_t i = 0; i < polygons.size(); i++)
+            snapshot.before[i] = { polygons[i].pos, polygons[i].rotation };
+        polygons[1].rotation += rotateRequests.exchange(0, std::memory_order_relaxed);
+
+        PHY_PROFILE_ZONE("SAT_test::step");
+        update(simStep * timeScale, canvas);
+        collide(snapshot);
+        accumulator -= simStep;
+
+        snapshot.time = std::chrono::duration<double>(Clock::now() - startTime).count();
+        snapshot.polygons.resize(polygons.size());
+        for(size_t i = 0; i < polygons.size(); i++)
+            snapshot.polygons[i] = { polygons[i].pos, polygons[i].rotation, (Uint8)polygons[i].color.b };
+        snapshots.publish();
     }
+}
 
-    return true;
+
+void simulationThread()
+{
+    const unsigned int cores = std::thread::hardware_concurrency();
+    JobSystem system(cores > 1 ? cores - 1 : 1);
+    jobs = &system;
+
+    while(true)
+    {
+        advanceSimulation();
+        std::this_thread::sleep_for(std::chrono::duration<double>(simStep - accumulator));
+    }
+}
+
+
+void interpolate()
+{
+    PHY_PROFILE_ZONE("SAT_test::interpolate");
+    const Snapshot& current = snapshots.readBuffer();
+    visible.clear();
+    visibleIndices.clear();
+    if(current.polygons.empty())
+        return;
+
+    // the render lags one step behind the simulation, blending the step of the snapshot
+    double now = std::chrono::duration<double>(Clock::now() - startTime).count();
+    float alpha = std::clamp((float)((now - current.time) / simStep), 0.0f, 1.0f);
+
+    auto lerp = [&](size_t i) {
+        const auto& a = current.before[i];
+        const auto& b = current.polygons[i];
+        return PolygonState{ a.pos + (b.pos - a.pos) * alpha, a.rotation + (b.rotation - a.rotation) * alpha, b.blue };
+    };
+
+    current.broadphase.query(camera.visibleBounds(1.0f), [](const Proxy& proxy) {
+        visible.push_back(proxy.body);
+    });
+
+    for(auto i: visible)
+    {
+        const auto& polygon = polygons[i];
+        const PolygonState state = lerp(i);
+
+        Vector2* out = &transformedPool[polygon.first];
+        for(size_t k = 0; k < polygon.vertices.size(); k++)
+            out[k] = camera.worldToScreen(state.pos + Vector2(polygon.vertices[k]).rotate(state.rotation));
+        out[polygon.vertices.size()] = out[0];
+
+        SDL_Color c{ (Uint8)polygon.color.r, (Uint8)polygon.color.g, state.blue, 255 };
+        std::fill_n(colorPool.begin() + polygon.first, polygon.vertices.size() + 1, c);
+
+        const size_t fanCount = (polygon.vertices.size() - 2) * 3;
+        visibleIndices.insert(visibleIndices.end(), 
+            fanIndices.begin() + polygon.fanFirst, fanIndices.begin() + polygon.fanFirst + fanCount);
+    }
 }
 
 
 void render(Canvas& canvas) 
 {
-    // draw polygons
-    SDL_SetRenderDrawColor(canvas.renderer, 255, 0, 0, 255);
-    for(auto& body: polygons)
+    PHY_PROFILE_ZONE("SAT_test::render");
+    // draw the visible polygons straight from the flat transformed vertices
+    if(fillPolygons)
     {
-        SDL_SetRenderDrawColor(canvas.renderer, body.color.r, body.color.g, body.color.b, 255);
-        for(size_t i = 0; i < body.vertices.size(); i++)
-        {
-            auto v1 = body.transformed[i];
-            auto v2 = body.transformed[(i + 1) % body.transformed.size()];
-            SDL_RenderDrawLine(canvas.renderer, v1.x, v1.y, v2.x, v2.y);
-        }
+        if(visibleIndices.empty())
+            return;
+        SDL_RenderGeometryRaw(canvas.renderer, nullptr, 
+            &transformedPool[0].x, sizeof(Vector2), 
+            colorPool.data(), sizeof(SDL_Color), 
+            nullptr, 0, transformedPool.size(), 
+            visibleIndices.data(), visibleIndices.size(), sizeof(int));
+        return;
+    }
+
+    for(auto i: visible)
+    {
+        const auto& body = polygons[i];
+        const SDL_Color& c = colorPool[body.first];
+        SDL_SetRenderDrawColor(canvas.renderer, c.r, c.g, c.b, 255);
+        SDL_RenderDrawLinesF(canvas.renderer, 
+            reinterpret_cast<const SDL_FPoint*>(&transformedPool[body.first]), body.vertices.size() + 1);
     }
 }
 
 
 void handleEvent(SDL_Event* evt)
 {
+    // the simulation thread owns the polygons, input is handed over through atomics
     if(evt->type == SDL_MOUSEMOTION)
     {
-        polygons[1].pos.x = evt->motion.x;
-        polygons[1].pos.y = evt->motion.y;
+        mouseScreen = Vector2(evt->motion.x, evt->motion.y);
+        Vector2 world = camera.screenToWorld(mouseScreen);
+        mouseX.store(world.x, std::memory_order_relaxed);
+        mouseY.store(world.y, std::memory_order_relaxed);
     }
+
+    if(evt->type == SDL_MOUSEWHEEL && evt->wheel.y != 0)
+        camera.zoomAt(evt->wheel.y > 0 ? 1.1f : 1.0f / 1.1f, mouseScreen);
     
     if(evt->type == SDL_KEYDOWN) {
         if(evt->key.keysym.sym == 4) {
-            polygons[1].rotation += 1.f;
+            rotateRequests.fetch_add(1, std::memory_order_relaxed);
+        }
+        if(evt->key.keysym.sym == SDLK_o) {
+            fillPolygons = !fillPolygons;
+        }
+#ifdef PHY_ENABLE_PROFILER
+        if(evt->key.keysym.sym == SDLK_p) {
+            Profiler::instance().printSummary(std::cout);
+        }
+#endif
+
+        const float panStep = 20.0f;
+        switch(evt->key.keysym.sym) {
+            case SDLK_LEFT: camera.pan(panStep, 0.0f); break;
+            case SDLK_RIGHT: camera.pan(-panStep, 0.0f); break;
+            case SDLK_UP: camera.pan(0.0f, panStep); break;
+            case SDLK_DOWN: camera.pan(0.0f, -panStep); break;
         }
     }
 }
@@ -279,20 +524,21 @@ void handleEvent(SDL_Event* evt)
 
 void mainLoop() 
 {
+#ifndef __EMSCRIPTEN_PTHREADS__
+    // no worker threads: step on the render thread, still through the snapshots
+    advanceSimulation();
+#endif
+
+    snapshots.update();
+    interpolate();
+
     SDL_SetRenderDrawColor(canvas.renderer, 0x00, 0x00, 0x00, 0xff);
     SDL_RenderClear(canvas.renderer);
     render(canvas);
     SDL_RenderPresent(canvas.renderer);
 
-    auto now = std::chrono::high_resolution_clock::now();
-    auto dt = (now - lastTime).count() * 10e-9;
-    lastTime = now;
-
     while(SDL_PollEvent(&canvas.evt) != 0)
         handleEvent(&canvas.evt);
-
-    update(dt, canvas);
-    
 }
 
 
@@ -0,0 +1,461 @@
+/**
+ * @file microBench/main.cpp
+ * @brief micro-benchmarks of the hot physics kernels
+ * @date 18th Oct, 2026
+ *
+ * Times the Vector2 math, the reference SAT test and the SAT manifold of
+ * the narrowphase for every pair of vertex counts, vertex transforms and
+ * both broadphases (sort and sweep and brute force). Every input comes
+ * from a fixed seed so runs are comparable, results are printed as ns/op
+ * and ops/s and written as JSON for tracking over time.
+ *
+ * The World phases (transform, broadphase, SAT, solve) are then run one at
+ * a time on scenario worlds inside a perf_event_open counter group, their
+ * cycles, instructions, cache and branch misses are reported per body or
+ * per pair. Without access to the counters only the time is reported.
+ *
+ *  micro_bench [--json path] [--seed N] [--min-ms N] [--filter substring]
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <phy/Vector.h>
+#include <phy/SAT.h>
+#include <phy/Narrowphase.h>
+#include <phy/Broadphase.h>
+#include <phy/TimeOfImpact.h>
+#include <phy/World.h>
+#include <phy/Scenario.h>
+#include <phy/PerfCounters.h>
+
+using namespace phy;
+
+
+struct Result
+{
+    std::string name;
+    double nsPerOp;
+    double opsPerSecond;
+    size_t iterations;
+};
+
+
+struct PhaseResult
+{
+    std::string name;
+    std::string unit;       // what the counts are divided by
+    double units;           // per measured step
+    double nsPerUnit;
+    PerfSample counters;    // summed over the measured steps
+    int steps;
+};
+
+
+struct PlacedPolygon
+{
+    std::vector<Vector2> vertices;
+    std::vector<Vector2> transformed;
+    Vector2 pos;
+    float rotation;
+};
+
+
+// keeps the optimizer from dropping the work of a benchmark
+volatile float floatSink;
+volatile size_t countSink;
+
+std::vector<Result> results;
+std::vector<PhaseResult> phaseResults;
+double minMilliseconds = 100.0;
+std::string filter;
+
+
+/// @brief Call body until minMilliseconds have passed and record the time per op
+/// @param name The name of the benchmark
+/// @param opsPerCall The operations done by one call of body
+/// @param body Callable doing opsPerCall operations
+template<typename Fn>
+void bench(const std::string& name, size_t opsPerCall, Fn&& body);
+
+
+/// @brief Random vectors with both coordinates in [-100, 100]
+std::vector<Vector2> randomVectors(std::mt19937& eng, size_t count);
+
+
+/// @brief Random polygons with the given vertex count in a square of side extent,
+/// about half of the neighbouring pairs overlap
+std::vector<PlacedPolygon> placedPolygons(std::mt19937& eng, int sides, size_t count, float extent);
+
+
+/// @brief Random proxies of radius 2 to 12 spread over a square sized for the count
+std::vector<Proxy> randomProxies(std::mt19937& eng, size_t count);
+
+
+void vectorBenchmarks(unsigned int seed);
+void satBenchmarks(unsigned int seed);
+void transformBenchmarks(unsigned int seed);
+void broadphaseBenchmarks(unsigned int seed);
+void phaseBenchmarks(unsigned int seed);
+
+
+bool writeJson(const std::string& path, unsigned int seed);
+
+
+int main(int argc, char** argv)
+{
+    std::string jsonPath = "micro_bench.json";
+    unsigned int seed = 1;
+
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if(arg == "--json") jsonPath = argv[i + 1];
+        else if(arg == "--seed") seed = std::strtoul(argv[i + 1], nullptr, 10);
+        else if(arg == "--min-ms") minMilliseconds = std::atof(argv[i + 1]);
+        else if(arg == "--filter") filter = argv[i + 1];
+        else {
+            std::cerr << "usage: micro_bench [--json path] [--seed N] [--min-ms N] [--filter substring]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << std::left << std::setw(36) << "benchmark" << std::right << std::setw(14) << "ns/op"
+        << std::setw(16) << "ops/s" << std::endl;
+
+    vectorBenchmarks(seed);
+    satBenchmarks(seed);
+    transformBenchmarks(seed);
+    broadphaseBenchmarks(seed);
+    phaseBenchmarks(seed);
+
+    if(!writeJson(jsonPath, seed)) {
+        std::cerr << "Unable to write " << jsonPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+
+template<typename Fn>
+void bench(const std::string& name, size_t opsPerCall, Fn&& body)
+{
+    if(!filter.empty() && name.find(filter) == std::string::npos)
+        return;
+
+    using clock = std::chrono::steady_clock;
+    body();     // warm up caches and branch predictors
+
+    size_t calls = 0;
+    auto start = clock::now();
+    double elapsed = 0.0;
+    for(size_t batch = 1; elapsed < minMilliseconds * 1e6; batch *= 2)
+    {
+        for(size_t i = 0; i < batch; i++)
+            body();
+        calls += batch;
+        elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    }
+
+    Result r{ name, elapsed / (calls * opsPerCall), 0.0, calls * opsPerCall };
+    r.opsPerSecond = 1e9 / r.nsPerOp;
+    results.push_back(r);
+
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(14) << r.nsPerOp << std::setw(16) << std::setprecision(0) << r.opsPerSecond << std::endl;
+}
+
+
+std::vector<Vector2> randomVectors(std::mt19937& eng, size_t count)
+{
+    std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+    std::vector<Vector2> v(count);
+    for(auto& p: v)
+        p = { coord(eng), coord(eng) };
+    return v;
+}
+
+
+std::vector<PlacedPolygon> placedPolygons(std::mt19937& eng, int sides, size_t count, float extent)
+{
+    std::uniform_real_distribution<float> coord(0.0f, extent);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    std::uniform_real_distribution<float> radius(10.0f, 30.0f);
+
+    std::vector<PlacedPolygon> polygons(count);
+    for(auto& p: polygons)
+    {
+        p.vertices = polarPolygon(sides, radius(eng));
+        p.pos = { coord(eng), coord(eng) };
+        p.rotation = angle(eng);
+        transformVertices(p.vertices, p.pos, p.rotation, p.transformed);
+    }
+    return polygons;
+}
+
+
+std::vector<Proxy> randomProxies(std::mt19937& eng, size_t count)
+{
+    // about 4 overlaps per proxy whatever the count
+    const float extent = std::sqrt((float)count) * 40.0f;
+    std::uniform_real_distribution<float> coord(0.0f, extent);
+    std::uniform_real_distribution<float> radius(2.0f, 12.0f);
+
+    std::vector<Proxy> proxies(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        Vector2 c{ coord(eng), coord(eng) };
+        float r = radius(eng);
+        proxies[i].box = { c - Vector2{ r, r }, c + Vector2{ r, r } };
+        proxies[i].body = static_cast<unsigned int>(i);
+    }
+    return proxies;
+}
+
+
+void vectorBenchmarks(unsigned int seed)
+{
+    std::mt19937 eng(seed);
+    const auto a = randomVectors(eng, 4096);
+    const auto b = randomVectors(eng, 4096);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    std::vector<float> angles(a.size());
+    for(auto& x: angles)
+        x = angle(eng);
+
+    bench("Vector2::rotate", a.size(), [&]() {
+        float acc = 0.0f;
+        for(size_t i = 0; i < a.size(); i++)
+            acc += Vector2(a[i]).rotate(angles[i]).x;
+        floatSink = acc;
+    });
+
+    bench("Vector2::normalize", a.size(), [&]() {
+        float acc = 0.0f;
+        for(size_t i = 0; i < a.size(); i++)
+            acc += Vector2(a[i]).normalize().y;
+        floatSink = acc;
+    });
+
+    bench("Vector2::dotProduct", a.size(), [&]() {
+        float acc = 0.0f;
+        for(size_t i = 0; i < a.size(); i++)
+            acc += a[i].dotProduct(b[i]);
+        floatSink = acc;
+    });
+
+    bench("Vector2::projection", a.size(), [&]() {
+        float acc = 0.0f;
+        for(size_t i = 0; i < a.size(); i++)
+            acc += a[i].projection(b[i]);
+        floatSink = acc;
+    });
+}
+
+
+void satBenchmarks(unsigned int seed)
+{
+    std::mt19937 eng(seed);
+    const size_t count = 256;
+
+    // two independent sets so n x n pairs are not a polygon against itself
+    std::vector<std::vector<PlacedPolygon>> first(7), second(7);
+    for(int sides = 3; sides <= 6; sides++) {
+        first[sides] = placedPolygons(eng, sides, count, 160.0f);
+        second[sides] = placedPolygons(eng, sides, count, 160.0f);
+    }
+
+    for(int n1 = 3; n1 <= 6; n1++)
+    {
+        for(int n2 = n1; n2 <= 6; n2++)
+        {
+            const auto& p1 = first[n1];
+            const auto& p2 = second[n2];
+            const std::string pair = std::to_string(n1) + "x" + std::to_string(n2);
+
+            bench("satCollision " + pair, count, [&]() {
+                size_t hits = 0;
+                for(size_t i = 0; i < count; i++)
+                    hits += satCollision(p1[i].transformed, p2[i].transformed);
+                countSink = hits;
+            });
+
+            bench("collidePolygons " + pair, count, [&]() {
+                size_t hits = 0;
+                Manifold m;
+                for(size_t i = 0; i < count; i++)
+                    hits += collidePolygons(polygonShape(p1[i].pos, p1[i].transformed),
+                        polygonShape(p2[i].pos, p2[i].transformed), m);
+                countSink = hits;
+            });
+        }
+    }
+}
+
+
+void transformBenchmarks(unsigned int seed)
+{
+    std::mt19937 eng(seed);
+    for(int sides: { 3, 6 })
+    {
+        auto polygons = placedPolygons(eng, sides, 1024, 1000.0f);
+        bench("transformVertices " + std::to_string(sides) + "-gon", polygons.size(), [&]() {
+            for(auto& p: polygons) {
+                p.rotation += 1.0f;
+                transformVertices(p.vertices, p.pos, p.rotation, p.transformed);
+            }
+            floatSink = polygons[0].transformed[0].x;
+        });
+    }
+}
+
+
+void broadphaseBenchmarks(unsigned int seed)
+{
+    std::mt19937 eng(seed);
+    Broadphase broadphase;
+    std::vector<BroadphasePair> pairs;
+
+    for(size_t count: { 256, 1024, 4096 })
+    {
+        const auto proxies = randomProxies(eng, count);
+
+        // one op is a whole frame: rebuild the proxies and emit every pair
+        bench("Broadphase SAP " + std::to_string(count), 1, [&]() {
+            broadphase.clear();
+            for(const auto& p: proxies)
+                broadphase.add(p);
+            broadphase.findPairs(pairs);
+            countSink = pairs.size();
+        });
+
+        bench("Broadphase brute force " + std::to_string(count), 1, [&]() {
+            pairs.clear();
+            for(size_t i = 0; i < proxies.size(); i++)
+                for(size_t j = i + 1; j < proxies.size(); j++)
+                    if(proxies[i].box.overlaps(proxies[j].box) && shouldCollide(proxies[i], proxies[j]))
+                        pairs.push_back({ proxies[i].body, proxies[j].body });
+            countSink = pairs.size();
+        });
+    }
+}
+
+
+void phaseBenchmarks(unsigned int seed)
+{
+    PerfCounterGroup group;
+    std::cout << "\nWorld phases, hardware counters "
+        << (group.available() ? "on" : "unavailable: " + group.getError()) << std::endl;
+    std::cout << std::left << std::setw(28) << "phase" << std::setw(9) << "per" << std::right
+        << std::setw(10) << "ns" << std::setw(10) << "cycles" << std::setw(10) << "instr"
+        << std::setw(7) << "IPC" << std::setw(11) << "cache-miss" << std::setw(12) << "branch-miss" << std::endl;
+
+    const int warmup = 60, steps = 120;
+    const float dt = 1.0f / 60.0f;
+
+    for(const char* name: { "ballpit", "rain" })
+    {
+        const Scenario& scenario = *findScenario(name);
+        if(!filter.empty() && std::string("phase ").append(name).find(filter) == std::string::npos)
+            continue;
+
+        World world;
+        scenario.build(world, { 1000, seed });
+        for(int i = 0; i < warmup; i++)
+            stepScenario(scenario, world, dt);
+
+        // transform, broadphase, SAT and solve are measured, the other phases only run
+        PhaseResult phases[4] = {
+            { std::string("phase ") + name + " transform", "body", 0.0, 0.0, {}, 0 },
+            { std::string("phase ") + name + " broadphase", "body", 0.0, 0.0, {}, 0 },
+            { std::string("phase ") + name + " SAT", "pair", 0.0, 0.0, {}, 0 },
+            { std::string("phase ") + name + " solve", "contact", 0.0, 0.0, {}, 0 },
+        };
+        double elapsed[4] = {};
+
+        auto measure = [&](int phase, double units, auto&& fn) {
+            auto start = std::chrono::steady_clock::now();
+            group.start();
+            fn();
+            phases[phase].counters += group.stop();
+            elapsed[phase] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            phases[phase].units += units;
+        };
+
+        for(int i = 0; i < steps; i++)
+        {
+            if(scenario.applyForces)
+                scenario.applyForces(world, dt);
+            measure(0, world.bodies.size(), [&]() { world.updateTransforms(); });
+            measure(1, world.bodies.size(), [&]() { world.findPairs(); });
+            measure(2, world.getPairs().size(), [&]() { world.narrowphase(); });
+            world.updateIslands();
+            world.integrateVelocities(dt);
+            measure(3, world.getContacts().size(), [&]() { world.solve(); });
+            world.integratePositions(dt);
+        }
+
+        for(int p = 0; p < 4; p++)
+        {
+            auto& r = phases[p];
+            const double units = std::max(r.units, 1.0);
+            r.nsPerUnit = elapsed[p] / units;
+            r.steps = steps;
+            r.units /= steps;
+            phaseResults.push_back(r);
+
+            // counters the group could not open print as -
+            auto per = [&](PerfEvent e, int width, int precision) {
+                std::cout << std::setw(width);
+                if(r.counters.has(e)) std::cout << std::setprecision(precision) << r.counters[e] / units;
+                else std::cout << "-";
+            };
+            std::cout << std::left << std::setw(28) << r.name << std::setw(9) << r.unit << std::right
+                << std::fixed << std::setprecision(1) << std::setw(10) << r.nsPerUnit;
+            per(PerfEvent::Cycles, 10, 1);
+            per(PerfEvent::Instructions, 10, 1);
+            std::cout << std::setw(7);
+            if(r.counters.ipc() > 0.0) std::cout << std::setprecision(2) << r.counters.ipc();
+            else std::cout << "-";
+            per(PerfEvent::CacheMisses, 11, 3);
+            per(PerfEvent::BranchMisses, 12, 3);
+            std::cout << std::endl;
+        }
+    }
+}
+
+
+bool writeJson(const std::string& path, unsigned int seed)
+{
+    std::ofstream file(path);
+    if(!file)
+        return false;
+
+    file << "{\n  \"seed\": " << seed << ",\n  \"benchmarks\": [\n";
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const auto& r = results[i];
+        file << "    { \"name\": \"" << r.name << "\", \"ns_per_op\": " << std::setprecision(4) << std::fixed << r.nsPerOp
+            << ", \"ops_per_s\": " << std::setprecision(0) << r.opsPerSecond
+            << ", \"iterations\": " << r.iterations << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ],\n  \"phases\": [\n";
+    for(size_t i = 0; i < phaseResults.size(); i++)
+    {
+        const auto& r = phaseResults[i];
+        file << "    { \"name\": \"" << r.name << "\", \"per\": \"" << r.unit << "\", \"units_per_step\": "
+            << std::setprecision(1) << r.units << ", \"ns_per_unit\": " << std::setprecision(4) << r.nsPerUnit;
+        for(size_t e = 0; e < (size_t)PerfEvent::Count; e++)
+            if(r.counters.valid[e])
+                file << ", \"" << perfEventNames[e] << "_per_unit\": " << r.counters.values[e] / std::max(r.units * r.steps, 1.0);
+        if(r.counters.has(PerfEvent::Cycles) && r.counters.has(PerfEvent::Instructions))
+            file << ", \"ipc\": " << r.counters.ipc();
+        file << " }" << (i + 1 < phaseResults.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,378 @@
+/**
+ * @file phySim/main.cpp
+ * @brief headless runner of the rigid body world
+ * @date 18th Oct, 2026
+ *
+ * Builds one of the scenarios of Scenario.h, steps a phy::World for a fixed
+ * number of steps without any window and prints the time of every step.
+ * Being a plain native executable it runs under perf, valgrind or any
+ * other profiler.
+ *
+ * --stats K prints the work counters of the World every K steps, and
+ * their totals at the end. Configured with -DPHY_PROFILER=ON it also
+ * prints the time of every profiler zone and --trace writes them as a
+ * Chrome trace.
+ *
+ * --record writes a checksum of the world every --checksum-every steps to a
+ * golden file, --check replays the run the golden file describes and
+ * reports the first step and body that diverge from it. --quantum rounds
+ * the state before hashing, 0 asks for bit identical results.
+ *
+ * --threads N steps the world on a JobSystem of N threads, 0 uses every
+ * hardware thread. The results are the same for any N, so golden files
+ * recorded on one thread check runs on many. ctest replays the goldens
+ * of tests/golden on 1, 2, 4 and 7 threads.
+ *
+ * --no-alloc-after N fails the run if a step after the first N allocates
+ * from the heap and prints where it did. Every thread is watched, the
+ * workers of --threads included. It needs the counting operator new of a
+ * build configured with -DPHY_ALLOC_TRACKER=ON.
+ *
+ * --asleep-by N fails the run if a dynamic body is still awake after step N,
+ * the check that a resting pile comes to rest and sleeps.
+ *
+ * --contained fails the run as soon as the center of a dynamic body leaves
+ * the bounds of the static bodies, the check that nothing tunnels out of the
+ * walls of scenarios like bullets and fastballs.
+ *
+ *  phy_sim [--scenario name] [--bodies N] [--steps N] [--dt seconds]
+ *          [--seed N] [--every K] [--stats K] [--trace path] [--quiet]
+ *          [--record path | --check path] [--checksum-every N] [--quantum q]
+ *          [--threads N] [--no-alloc-after N] [--asleep-by N] [--contained]
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <algorithm>
+#include <phy/World.h>
+#include <phy/JobSystem.h>
+#include <phy/Scenario.h>
+#include <phy/Profiler.h>
+#include <phy/Checksum.h>
+#include <phy/AllocTracker.h>
+
+using namespace phy;
+
+PHY_INSTALL_ALLOCATION_HOOKS()
+
+// a settled pile keeps about 8 candidate pairs per body, reserving past that
+// keeps the pair and contact buffers from growing in the middle of a run
+constexpr size_t pairsPerBody = 16;
+
+
+struct Options
+{
+    std::string scenario = "rain";
+    int bodies = 500;
+    int steps = 600;
+    float dt = 1.0f / 60.0f;
+    unsigned int seed = 1;
+    int every = 1;          // print one step out of every
+    bool quiet = false;     // only print the summary
+    int stats = 0;          // print the counters every stats steps, 0 never
+    std::string trace;      // Chrome trace output, needs the profiler
+    std::string record;     // golden file to write
+    std::string check;      // golden file to compare with
+    int checksumEvery = 10;
+    float quantum = 0.0f;   // 0 hashes the raw bits
+    int noAllocAfter = -1;  // steps allowed to allocate, -1 never checks
+    int threads = 1;        // threads of the job system, 1 steps without one
+    int asleepBy = -1;      // step every dynamic body must sleep from, -1 never checks
+    bool contained = false; // fail when a dynamic body leaves the static bounds
+};
+
+
+/// @brief Parse the command line
+/// @return false if an argument is unknown or malformed
+bool parseOptions(int argc, char** argv, Options& options);
+
+
+/// @brief Print the usage with every scenario of the table
+void printUsage();
+
+
+/// @brief First line of a golden file, the options needed to replay the run
+void writeGoldenHeader(std::ostream& out, const Options& options);
+
+
+/// @brief Take the run options of a golden file over the command line ones
+bool readGoldenHeader(std::istream& in, Options& options);
+
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if(!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    // a check replays the run the golden file was recorded from
+    std::ifstream golden;
+    std::ofstream recording;
+    if(!options.check.empty()) {
+        golden.open(options.check);
+        if(!golden || !readGoldenHeader(golden, options)) {
+            std::cerr << "Unable to read the golden file " << options.check << std::endl;
+            return 1;
+        }
+    }
+    else if(!options.record.empty()) {
+        recording.open(options.record);
+        if(!recording) {
+            std::cerr << "Unable to write " << options.record << std::endl;
+            return 1;
+        }
+        writeGoldenHeader(recording, options);
+    }
+
+    const Scenario* scenario = findScenario(options.scenario);
+    if(!scenario) {
+        std::cerr << "Unknown scenario " << options.scenario << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    World world;
+    scenario->build(world, { options.bodies, options.seed });
+
+    std::unique_ptr<JobSystem> jobs;
+    if(options.threads != 1) {
+        jobs = std::make_unique<JobSystem>(options.threads);
+        world.setJobSystem(jobs.get());
+    }
+    world.reserve(world.bodies.size() * pairsPerBody);
+
+    std::cout << "scenario " << options.scenario << ", " << world.bodies.size() << " bodies, "
+        << options.steps << " steps of " << options.dt << "s";
+    if(jobs)
+        std::cout << ", " << jobs->threads() << " threads";
+    std::cout << std::endl;
+    if(!options.quiet)
+        std::cout << "step,ms,awake,sleeping,contacts,islands" << std::endl;
+
+    if(options.noAllocAfter >= 0 && !AllocTracker::installed()) {
+        std::cerr << "--no-alloc-after ignored, configure with -DPHY_ALLOC_TRACKER=ON to count allocations" << std::endl;
+        options.noAllocAfter = -1;
+    }
+
+    // static bodies never move, the bounds of the run are theirs once built
+    AABB walls{ { INFINITY, INFINITY }, { -INFINITY, -INFINITY } };
+    auto extend = [&walls](const Vector2& p, float r) {
+        walls.min = { std::min(walls.min.x, p.x - r), std::min(walls.min.y, p.y - r) };
+        walls.max = { std::max(walls.max.x, p.x + r), std::max(walls.max.y, p.y + r) };
+    };
+    for(const auto& b: world.bodies)
+    {
+        if(!b.isStatic())
+            continue;
+        if(b.vertices.empty())
+            extend(b.pos, b.radius);
+        for(const auto& v: b.transformed)
+            extend(v, 0.0f);
+    }
+
+    std::vector<double> times;
+    times.reserve(options.steps);
+    int checked = 0;
+    for(int i = 0; i < options.steps; i++)
+    {
+        AllocationScope allocations("step", options.noAllocAfter >= 0 && i >= options.noAllocAfter, AllocationThreads::All);
+        auto start = std::chrono::steady_clock::now();
+        stepScenario(*scenario, world, options.dt);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        allocations.stop();
+        times.push_back(ms);
+
+        if(options.noAllocAfter >= 0 && i >= options.noAllocAfter && !allocations.clean()) {
+            std::cout << "ALLOCATED in step " << i << ", ";
+            allocations.report(std::cout);
+            return 1;
+        }
+
+        if(options.asleepBy >= 0 && i >= options.asleepBy && world.getMetrics().awakeBodies > 0) {
+            std::cout << "AWAKE at step " << i << ", " << world.getMetrics().awakeBodies << " bodies" << std::endl;
+            return 1;
+        }
+
+        for(size_t k = 0; options.contained && k < world.bodies.size(); k++)
+        {
+            const auto& b = world.bodies[k];
+            if(!b.isStatic() && (b.pos.x < walls.min.x || b.pos.x > walls.max.x || b.pos.y < walls.min.y || b.pos.y > walls.max.y)) {
+                std::cout << "ESCAPED at step " << i << ", body " << k << " at " << b.pos.x << " " << b.pos.y << std::endl;
+                return 1;
+            }
+        }
+
+        if(!options.quiet && i % options.every == 0) {
+            const auto& m = world.getMetrics();
+            std::cout << i << "," << std::fixed << std::setprecision(4) << ms << "," << m.awakeBodies << ","
+                << m.sleepingBodies << "," << m.contacts << "," << m.islands << std::endl;
+        }
+
+        if(options.stats > 0 && (i + 1) % options.stats == 0) {
+            const auto& stats = world.getStats();
+            const auto& last = stats.lastStep();
+            std::cout << "stats " << i << ":";
+            for(size_t c = 0; c < (size_t)Counter::Count; c++)
+                std::cout << " " << counterNames[c] << "=" << last.values[c];
+            std::cout << std::fixed << std::setprecision(4) << " p50_ms=" << stats.stepTimes().percentile(0.5) * 1e-6
+                << " p99_ms=" << stats.stepTimes().percentile(0.99) * 1e-6
+                << " max_ms=" << stats.stepTimes().max() * 1e-6 << std::endl;
+        }
+
+        if((recording.is_open() || golden.is_open()) && (i + 1) % options.checksumEvery == 0)
+        {
+            const ChecksumRecord actual = checksum(world, i + 1, options.quantum);
+            if(recording.is_open()) {
+                writeRecord(recording, actual);
+                continue;
+            }
+
+            ChecksumRecord expected;
+            if(!readRecord(golden, expected) || expected.step != actual.step) {
+                std::cerr << "golden file " << options.check << " has no record of step " << actual.step << std::endl;
+                return 1;
+            }
+
+            long body = firstDivergence(expected, actual);
+            if(body >= 0) {
+                std::cout << "DIVERGED at step " << actual.step << ", ";
+                if(body < (long)world.bodies.size() && body < (long)expected.bodies.size()) {
+                    const auto& b = world.bodies[body];
+                    std::cout << "first at body " << body << std::setprecision(9)
+                        << ": pos " << b.pos.x << " " << b.pos.y << " vel " << b.vel.x << " " << b.vel.y
+                        << " rotation " << b.rotation << " angVel " << b.angVel << " awake " << b.awake << std::endl;
+                } else {
+                    std::cout << expected.bodies.size() << " bodies expected, " << actual.bodies.size() << " found" << std::endl;
+                }
+                return 1;
+            }
+            checked++;
+        }
+    }
+
+    if(recording.is_open())
+        std::cout << "recorded " << options.steps / options.checksumEvery << " checksums to " << options.record << std::endl;
+    if(options.contained)
+        std::cout << "every body stayed within the static bodies" << std::endl;
+    if(options.asleepBy >= 0)
+        std::cout << "every body asleep from step " << options.asleepBy << std::endl;
+    if(options.noAllocAfter >= 0)
+        std::cout << "no allocation in steps " << options.noAllocAfter << " to " << options.steps - 1 << std::endl;
+    if(golden.is_open())
+        std::cout << "matches " << options.check << ": " << checked << " checksums up to step " << options.steps << std::endl;
+
+    double total = 0.0;
+    for(double t: times)
+        total += t;
+    std::sort(times.begin(), times.end());
+    auto percentile = [&](double p) { return times[std::min(times.size() - 1, (size_t)(p * times.size()))]; };
+
+    std::cout << std::fixed << std::setprecision(4) << "total " << total << " ms, mean " << total / times.size()
+        << " ms, p50 " << percentile(0.5) << " ms, p99 " << percentile(0.99) << " ms, max " << times.back() << " ms" << std::endl;
+
+    if(options.stats > 0)
+        world.getStats().print(std::cout);
+
+#ifdef PHY_ENABLE_PROFILER
+    Profiler::instance().printSummary(std::cout, total + 1000.0);
+    if(!options.trace.empty() && !Profiler::instance().writeChromeTrace(options.trace)) {
+        std::cerr << "Unable to write " << options.trace << std::endl;
+        return 1;
+    }
+#else
+    if(!options.trace.empty())
+        std::cerr << "--trace ignored, configure with -DPHY_PROFILER=ON to record zones" << std::endl;
+#endif
+    return 0;
+}
+
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "--quiet") {
+            options.quiet = true;
+            continue;
+        }
+        if(arg == "--contained") {
+            options.contained = true;
+            continue;
+        }
+        if(i + 1 >= argc)
+            return false;
+
+        const char* value = argv[++i];
+        if(arg == "--scenario") options.scenario = value;
+        else if(arg == "--bodies") options.bodies = std::atoi(value);
+        else if(arg == "--steps") options.steps = std::atoi(value);
+        else if(arg == "--dt") options.dt = std::atof(value);
+        else if(arg == "--seed") options.seed = std::strtoul(value, nullptr, 10);
+        else if(arg == "--every") options.every = std::max(1, std::atoi(value));
+        else if(arg == "--stats") options.stats = std::max(0, std::atoi(value));
+        else if(arg == "--trace") options.trace = value;
+        else if(arg == "--record") options.record = value;
+        else if(arg == "--check") options.check = value;
+        else if(arg == "--checksum-every") options.checksumEvery = std::max(1, std::atoi(value));
+        else if(arg == "--quantum") options.quantum = std::max(0.0, std::atof(value));
+        else if(arg == "--threads") options.threads = std::max(0, std::atoi(value));
+        else if(arg == "--no-alloc-after") options.noAllocAfter = std::max(0, std::atoi(value));
+        else if(arg == "--asleep-by") options.asleepBy = std::max(0, std::atoi(value));
+        else return false;
+    }
+    return options.bodies > 0 && options.steps > 0 && options.dt > 0.0f &&
+        (options.record.empty() || options.check.empty());
+}
+
+
+void printUsage()
+{
+    std::cerr << "usage: phy_sim [--scenario name] [--bodies N] [--steps N] "
+        "[--dt seconds] [--seed N] [--every K] [--stats K] [--trace path] [--quiet] "
+        "[--record path | --check path] [--checksum-every N] [--quantum q] [--threads N] [--no-alloc-after N] [--asleep-by N] [--contained]\n\nscenarios:\n";
+    for(const auto& s: scenarios)
+        std::cerr << "  " << std::left << std::setw(10) << s.name << s.description << "\n";
+}
+
+
+void writeGoldenHeader(std::ostream& out, const Options& options)
+{
+    out << std::setprecision(9) << "# phy_sim golden scenario " << options.scenario << " bodies " << options.bodies
+        << " steps " << options.steps << " dt " << options.dt << " seed " << options.seed
+        << " checksum-every " << options.checksumEvery << " quantum " << options.quantum << "\n";
+}
+
+
+bool readGoldenHeader(std::istream& in, Options& options)
+{
+    std::string line, word;
+    if(!std::getline(in, line))
+        return false;
+
+    std::istringstream header(line);
+    header >> word >> word >> word;     // # phy_sim golden
+    if(word != "golden")
+        return false;
+
+    for(std::string key; header >> key;)
+    {
+        if(key == "scenario") header >> options.scenario;
+        else if(key == "bodies") header >> options.bodies;
+        else if(key == "steps") header >> options.steps;
+        else if(key == "dt") header >> options.dt;
+        else if(key == "seed") header >> options.seed;
+        else if(key == "checksum-every") header >> options.checksumEvery;
+        else if(key == "quantum") header >> options.quantum;
+        else return false;
+    }
+    return !header.bad() && options.checksumEvery > 0;
+}
@@ -0,0 +1,400 @@
+/**
+ * @file renderBench/main.cpp
+ * @brief CPU side cost of the Canvas2d draw paths
+ * @date 18th Oct, 2026
+ * 
+ * Counts the graphics api commands each draw path of Canvas2d submits for
+ * a frame of balls or polygon outlines and times how long the CPU takes to
+ * record the batched path. Both paths run the same Batch.h functions as
+ * Canvas2d on a CountingApi instead of OpenGL, so nothing here needs an
+ * OpenGL context and it runs anywhere. The immediate line path is the line
+ * batch flushed after every segment, as the old Canvas2d::drawLine drew it.
+ * 
+ * The circle tables compare the vertex and fragment work of the 36 segment
+ * circle mesh with the single quad SDF shader of Canvas2d. Vertices are the
+ * counted vertex shader invocations of both paths. The fragments of a
+ * single circle are measured by rasterizing the mesh, the quad and the true
+ * circle with the SoftwareRenderer, which samples pixel centers like the GPU;
+ * the per frame fragment totals are analytic estimates from the area of the
+ * mesh and of the quad, and are labelled so in the output.
+ * 
+ * The last table rasterizes the same frames with the headless SoftwareRenderer
+ * for one thread and for every hardware thread, the tiles then being jobs of
+ * a JobSystem. Pass a .ppm or .png path to save its last frame.
+ *
+ * Built with -DPHY_ALLOC_TRACKER=ON it then checks that a software frame,
+ * recording and flush, no longer allocates on the calling thread once warmed
+ * up, and fails with the allocation sites if it does.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <phy/Batch.h>
+#include <phy/SoftwareRenderer.h>
+#include <phy/JobSystem.h>
+#include <phy/AllocTracker.h>
+
+using namespace phy;
+
+PHY_INSTALL_ALLOCATION_HOOKS()
+
+
+struct BallData
+{
+    float x;
+    float y;
+    float radius;
+    unsigned int color;
+};
+
+
+/// @brief Record the outline of every ball as a hexagon and flush the LineBatch
+/// after every segment, like the old Canvas2d::drawLine
+/// @return The counters of every flush
+DrawCounters immediateLines(const std::vector<BallData>& balls, LineBatch& batch);
+
+
+/// @brief Record the outline of every ball as a hexagon into a LineBatch
+/// @return The counters of a single flush
+DrawCounters batchedLines(const std::vector<BallData>& balls, LineBatch& batch);
+
+
+/// @brief Add segment i of the hexagon outlining a ball to the batch
+void addHexagonSegment(const BallData& b, int i, LineBatch& batch);
+
+
+/// @brief Commands Canvas2d submits when every ball calls setFillColor and drawArc
+/// @param balls The balls of the frame
+DrawCounters immediateCircles(const std::vector<BallData>& balls);
+
+
+/// @brief Record every ball into a CircleBatch and count the commands of its flush
+/// @param balls The balls of the frame
+/// @param batch The batch to record into, cleared on return like Canvas2d::flush
+/// @return The counters of a single flush
+DrawCounters batchedCircles(const std::vector<BallData>& balls, CircleBatch& batch);
+
+
+/// @brief Rasterize the circle mesh, the SDF quad and the exact circle of radius r
+/// alone on the renderer and count their pixels
+/// @param meshMissed Set to the pixels of the exact circle the mesh leaves out
+void circleCoverage(float r, SoftwareRenderer& renderer, size_t& mesh, size_t& sdf, size_t& meshMissed);
+
+
+/// @brief Draw every ball filled, with a hexagon outline and a filled triangle
+/// on top, into the software renderer
+/// @return milliseconds spent recording and flushing the frame
+double softwareFrame(const std::vector<BallData>& balls, SoftwareRenderer& renderer);
+
+
+std::vector<BallData> makeBalls(size_t count)
+{
+    std::mt19937 eng(42);
+    std::uniform_real_distribution<float> pos(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> radius(2.0f, 30.0f);
+
+    std::vector<BallData> balls(count);
+    for(auto& b: balls)
+        b = { pos(eng), pos(eng), radius(eng), static_cast<unsigned int>(eng() & 0xffffff) };
+    return balls;
+}
+
+
+int main(int argc, char** argv)
+{
+    const int frames = 100;
+    CircleBatch batch;
+    LineBatch lines;
+
+    std::cout << std::setw(10) << "balls" << std::setw(18) << "immediate cmds" 
+        << std::setw(16) << "batched cmds" << std::setw(18) << "record ns/ball" << std::endl;
+
+    for(size_t count: { 100, 1000, 10000, 100000 })
+    {
+        auto balls = makeBalls(count);
+        auto immediate = immediateCircles(balls);
+
+        DrawCounters batched;
+        auto start = std::chrono::high_resolution_clock::now();
+        for(int f = 0; f < frames; f++)
+            batched = batchedCircles(balls, batch);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::cout << std::setw(10) << count << std::setw(18) << immediate.total() 
+            << std::setw(16) << batched.total() << std::setw(18) << std::fixed << std::setprecision(2) 
+            << elapsed / (frames * count) << std::endl;
+    }
+
+    std::cout << std::endl << std::setw(10) << "segments" << std::setw(18) << "immediate cmds" 
+        << std::setw(16) << "batched cmds" << std::setw(18) << "record ns/seg" << std::endl;
+
+    for(size_t count: { 100, 1000, 10000, 100000 })
+    {
+        auto balls = makeBalls(count / 6);
+        auto immediate = immediateLines(balls, lines);
+
+        DrawCounters batched;
+        auto start = std::chrono::high_resolution_clock::now();
+        for(int f = 0; f < frames; f++)
+            batched = batchedLines(balls, lines);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::cout << std::setw(10) << balls.size() * 6 << std::setw(18) << immediate.total() 
+            << std::setw(16) << batched.total() << std::setw(18) << std::fixed << std::setprecision(2) 
+            << elapsed / (frames * balls.size() * 6) << std::endl;
+    }
+
+    std::cout << std::endl << std::setw(10) << "radius" << std::setw(14) << "mesh verts" << std::setw(14) << "sdf verts"
+        << std::setw(16) << "mesh frags" << std::setw(16) << "sdf frags" << std::setw(18) << "mesh missed px" << std::endl;
+
+    SoftwareRenderer coverage(600, 600);
+    for(float r: { 1.0f, 4.0f, 16.0f, 64.0f, 256.0f })
+    {
+        const std::vector<BallData> ball{ { 300.0f, 300.0f, r, 0xffffff } };
+        size_t mesh, sdf, missed;
+        circleCoverage(r, coverage, mesh, sdf, missed);
+        std::cout << std::setw(10) << std::setprecision(0) << r 
+            << std::setw(14) << immediateCircles(ball).vertices << std::setw(14) << batchedCircles(ball, batch).vertices
+            << std::setw(16) << mesh << std::setw(16) << sdf << std::setw(18) << missed << std::endl;
+    }
+
+    std::cout << std::endl << std::setw(10) << "balls" << std::setw(16) << "mesh Mverts" << std::setw(16) << "sdf Mverts"
+        << std::setw(20) << "mesh Mfrags (est)" << std::setw(20) << "sdf Mfrags (est)" << std::endl;
+
+    for(size_t count: { 100, 1000, 10000, 100000 })
+    {
+        auto balls = makeBalls(count);
+        double meshFragments = 0.0, sdfFragments = 0.0;
+        for(const auto& b: balls) {
+            meshFragments += circleFragmentCount(CircleMode::Mesh, b.radius);
+            sdfFragments += circleFragmentCount(CircleMode::SDF, b.radius);
+        }
+
+        std::cout << std::setw(10) << count << std::setprecision(3)
+            << std::setw(16) << immediateCircles(balls).vertices * 1e-6 
+            << std::setw(16) << batchedCircles(balls, batch).vertices * 1e-6
+            << std::setw(20) << meshFragments * 1e-6 << std::setw(20) << sdfFragments * 1e-6 << std::endl;
+    }
+
+    const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    SoftwareRenderer renderer(1000, 1000);
+    JobSystem jobs(hardwareThreads);
+
+    std::cout << std::endl << std::setw(10) << "balls" << std::setw(10) << "threads" 
+        << std::setw(14) << "ms/frame" << std::setw(16) << "Mprims/s" << std::setw(16) << "binned/prim" << std::endl;
+
+    for(size_t count: { 100, 1000, 10000, 100000 })
+    {
+        auto balls = makeBalls(count);
+        for(unsigned int threads: { 1u, hardwareThreads })
+        {
+            renderer.setThreads(threads);
+            renderer.setJobSystem(threads > 1 ? &jobs : nullptr);
+            const int softwareFrames = count >= 100000 ? 5 : 20;
+            double ms = 0.0;
+            for(int f = 0; f < softwareFrames; f++)
+                ms += softwareFrame(balls, renderer);
+            ms /= softwareFrames;
+
+            const auto& stats = renderer.getStats();
+            std::cout << std::setw(10) << count << std::setw(10) << threads 
+                << std::setw(14) << std::fixed << std::setprecision(3) << ms 
+                << std::setw(16) << stats.commands / (ms * 1000.0)
+                << std::setw(16) << (double)stats.binnedCommands / stats.commands << std::endl;
+
+            if(threads == hardwareThreads)
+                break;
+        }
+    }
+
+    if(AllocTracker::installed())
+    {
+        // threads started by flush would allocate, the job system's are already running
+        auto balls = makeBalls(10000);
+        renderer.setJobSystem(&jobs);
+        softwareFrame(balls, renderer);
+
+        AllocationScope allocations("software frame", true, AllocationThreads::All);
+        softwareFrame(balls, renderer);
+        allocations.stop();
+        std::cout << std::endl;
+        if(!allocations.clean()) {
+            std::cout << "ALLOCATED in ";
+            allocations.report(std::cout);
+            return 1;
+        }
+        std::cout << "no allocation in a warmed up software frame of " << balls.size() << " balls" << std::endl;
+    }
+
+    if(argc > 1)
+    {
+        std::string path = argv[1];
+        bool png = path.size() > 4 && path.substr(path.size() - 4) == ".png";
+        if(!(png ? renderer.writePNG(path.c_str()) : renderer.writePPM(path.c_str()))) {
+            std::cerr << "Unable to write " << path << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+DrawCounters immediateCircles(const std::vector<BallData>& balls)
+{
+    // any non zero object names, CountingApi does not count unbinds
+    const int fillColor = 0, matrix = 1;
+    const unsigned int circleVao = 1;
+
+    CountingApi api;
+    for(const auto& b: balls)
+    {
+        const float m[16] = { b.radius, 0, 0, 0, 0, b.radius, 0, 0, 0, 0, 1, 0, b.x, b.y, 0, 1 };
+        uploadFillColor(api, fillColor, b.color, 1.0f);
+        drawMeshCircle(api, matrix, m, circleVao, circleIndexCount(CircleMode::Mesh));
+    }
+    return api.counters;
+}
+
+
+DrawCounters batchedCircles(const std::vector<BallData>& balls, CircleBatch& batch)
+{
+    for(const auto& b: balls)
+        batch.add(b.x, b.y, b.radius, b.color);
+
+    BatchTarget target;
+    target.program = 1;
+    target.projection = 0;
+    target.buffer = 1;
+    target.vao = 1;
+    target.indexCount = circleIndexCount(CircleMode::SDF);
+
+    const float projection[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    size_t capacity = 0;    // the buffer is only named, growing it costs no command
+    CountingApi api;
+    flushCircleBatch(api, target, projection, batch, capacity);
+    return api.counters;
+}
+
+
+/// @brief The line target of Canvas2d::flushLines with non zero object names
+BatchTarget lineTarget()
+{
+    BatchTarget target;
+    target.program = 1;
+    target.projection = 0;
+    target.buffer = 1;
+    target.vao = 1;
+    return target;
+}
+
+
+DrawCounters immediateLines(const std::vector<BallData>& balls, LineBatch& batch)
+{
+    const BatchTarget target = lineTarget();
+    const float projection[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    size_t capacity = 0;
+    CountingApi api;
+    for(const auto& b: balls)
+    {
+        for(int i = 0; i < 6; i++)
+        {
+            addHexagonSegment(b, i, batch);
+            flushLineBatch(api, target, projection, batch, capacity);
+        }
+    }
+    return api.counters;
+}
+
+
+DrawCounters batchedLines(const std::vector<BallData>& balls, LineBatch& batch)
+{
+    for(const auto& b: balls)
+        for(int i = 0; i < 6; i++)
+            addHexagonSegment(b, i, batch);
+
+    const float projection[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    size_t capacity = 0;
+    CountingApi api;
+    flushLineBatch(api, lineTarget(), projection, batch, capacity);
+    return api.counters;
+}
+
+
+void addHexagonSegment(const BallData& b, int i, LineBatch& batch)
+{
+    float a1 = i * 3.14159f / 3;
+    float a2 = (i + 1) * 3.14159f / 3;
+    batch.add(b.x + std::cos(a1) * b.radius, b.y + std::sin(a1) * b.radius,
+        b.x + std::cos(a2) * b.radius, b.y + std::sin(a2) * b.radius, b.color);
+}
+
+
+void circleCoverage(float r, SoftwareRenderer& renderer, size_t& mesh, size_t& sdf, size_t& meshMissed)
+{
+    const float x = renderer.getWidth() * 0.5f, y = renderer.getHeight() * 0.5f;
+    Vector2 fan[circleSegments];
+    for(int i = 0; i < circleSegments; i++) {
+        float a = i * 2 * 3.14159265f / circleSegments;
+        fan[i] = { x + std::cos(a) * r, y + std::sin(a) * r };
+    }
+    // the SDF quad bounds the circle with the 1 pixel antialiasing fringe
+    const float h = r + 1.0f;
+    const Vector2 quad[4] = { { x - h, y - h }, { x + h, y - h }, { x + h, y + h }, { x - h, y + h } };
+
+    auto covered = [&]() {
+        renderer.flush();
+        const size_t pixels = static_cast<size_t>(renderer.getWidth()) * renderer.getHeight();
+        return static_cast<size_t>(std::count_if(renderer.pixels(), renderer.pixels() + pixels,
+            [](uint32_t p) { return p != 0; }));
+    };
+
+    renderer.clear(0);
+    renderer.fillPolygon(fan, circleSegments, 0xffffff);
+    mesh = covered();
+
+    renderer.clear(0);
+    renderer.fillPolygon(quad, 4, 0xffffff);
+    sdf = covered();
+
+    renderer.clear(0);
+    renderer.fillCircle(x, y, r, 0xffffff);
+    renderer.fillPolygon(fan, circleSegments, 0);
+    meshMissed = covered();
+}
+
+
+double softwareFrame(const std::vector<BallData>& balls, SoftwareRenderer& renderer)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    renderer.clear(0x101010);
+
+    for(const auto& b: balls)
+        renderer.fillCircle(b.x, b.y, b.radius, b.color);
+
+    for(const auto& b: balls)
+    {
+        for(int i = 0; i < 6; i++)
+        {
+            float a1 = i * 3.14159f / 3;
+            float a2 = (i + 1) * 3.14159f / 3;
+            renderer.drawLine(b.x + std::cos(a1) * b.radius, b.y + std::sin(a1) * b.radius,
+                b.x + std::cos(a2) * b.radius, b.y + std::sin(a2) * b.radius, 0xffffff);
+        }
+
+        Vector2 triangle[3] = { 
+            { b.x, b.y - b.radius * 0.5f }, 
+            { b.x + b.radius * 0.5f, b.y + b.radius * 0.4f }, 
+            { b.x - b.radius * 0.5f, b.y + b.radius * 0.4f } };
+        renderer.fillPolygon(triangle, 3, ~b.color & 0xffffff, 0.5f);
+    }
+
+    renderer.flush();
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
@@ -0,0 +1,429 @@
+/**
+ * @file renderTest/main.cpp
+ * @brief checks of the render layer that need no window
+ * @date 18th Oct, 2026
+ *
+ * Every suite runs a few fixed cases against one piece of the render layer
+ * and reports each check that fails. The camera suite maps points between
+ * world and screen and back, compares the view box with the viewport
+ * corners and draws a world whose bodies sit on, just inside and just
+ * outside the edges of the view through drawVisible. The transform suite
+ * checks Affine2 inverses and multiplication order, and that a
+ * TransformStack pushed past its capacity still pops back to every level.
+ *
+ * The software suite rasterizes a fixed random frame with the
+ * SoftwareRenderer on 1 to 7 threads, on a JobSystem and with several tile
+ * sizes, and every framebuffer must be the same to the bit. Given --golden
+ * the FNV-1a hash of that framebuffer must also match the one of the file,
+ * which --record writes. ctest checks tests/golden/software_frame.txt.
+ *
+ *  render_test [--suite substring] [--golden path | --record path]
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <phy/Vector.h>
+#include <phy/Transform.h>
+#include <phy/Camera.h>
+#include <phy/World.h>
+#include <phy/DrawList.h>
+#include <phy/Scenario.h>
+#include <phy/SAT.h>
+#include <phy/SoftwareRenderer.h>
+#include <phy/JobSystem.h>
+#include <phy/Checksum.h>
+
+using namespace phy;
+
+
+struct Suite
+{
+    const char* name;
+    /// @return one line for every failed check, empty if they all pass
+    std::string (*run)();
+};
+
+
+/// @brief Append what to failures unless ok
+void check(bool ok, const std::string& what, std::string& failures);
+
+bool near(const Vector2& a, const Vector2& b, float tolerance);
+
+bool near(const Affine2& a, const Affine2& b, float tolerance);
+
+std::string str(const Vector2& v);
+
+
+/// @brief Record the fixed frame of the software suite: overlapping translucent
+/// circles, lines, polygons and circle outlines, some of them off screen
+void softwareFrame(SoftwareRenderer& renderer, const DrawList& outlines, unsigned int seed);
+
+/// @brief FNV-1a of the framebuffer
+uint64_t hashFramebuffer(const SoftwareRenderer& renderer);
+
+
+std::string testCamera();
+std::string testTransform();
+std::string testSoftware();
+
+const Suite suites[] = {
+    { "camera", testCamera },
+    { "transform", testTransform },
+    { "software", testSoftware },
+};
+
+std::string goldenPath;     // checked by the software suite
+std::string recordPath;     // written by the software suite
+
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if(arg == "--suite") filter = argv[i + 1];
+        else if(arg == "--golden") goldenPath = argv[i + 1];
+        else if(arg == "--record") recordPath = argv[i + 1];
+    }
+
+    bool failed = false;
+    for(const auto& s: suites)
+    {
+        if(!filter.empty() && std::string(s.name).find(filter) == std::string::npos)
+            continue;
+        const std::string failures = s.run();
+        std::cout << std::left << std::setw(16) << s.name << std::right << (failures.empty() ? "ok" : "FAILED") << std::endl;
+        std::cout << failures;
+        failed = failed || !failures.empty();
+    }
+    return failed ? 1 : 0;
+}
+
+
+void check(bool ok, const std::string& what, std::string& failures)
+{
+    if(!ok)
+        failures += "  " + what + "\n";
+}
+
+bool near(const Vector2& a, const Vector2& b, float tolerance)
+{
+    return std::abs(a.x - b.x) <= tolerance && std::abs(a.y - b.y) <= tolerance;
+}
+
+bool near(const Affine2& a, const Affine2& b, float tolerance)
+{
+    return std::abs(a.a - b.a) <= tolerance && std::abs(a.b - b.b) <= tolerance
+        && std::abs(a.c - b.c) <= tolerance && std::abs(a.d - b.d) <= tolerance
+        && std::abs(a.tx - b.tx) <= tolerance && std::abs(a.ty - b.ty) <= tolerance;
+}
+
+std::string str(const Vector2& v)
+{
+    std::ostringstream out;
+    out << "(" << v.x << ", " << v.y << ")";
+    return out.str();
+}
+
+
+std::string testCamera()
+{
+    std::string failures;
+
+    // world <-> screen round trip, and the transform agrees with worldToScreen
+    for(float zoom: { 0.05f, 0.5f, 1.0f, 2.5f, 20.0f })
+    {
+        Camera2D camera(800.0f, 600.0f);
+        camera.center = { -130.0f, 2400.0f };
+        camera.zoom = zoom;
+        const Affine2 toScreen = camera.transform();
+        const Affine2 toWorld = toScreen.inverse();
+
+        for(float x = -3000.0f; x <= 3000.0f; x += 750.0f)
+            for(float y = -1000.0f; y <= 5000.0f; y += 750.0f)
+            {
+                const Vector2 p{ x, y };
+                const Vector2 s = camera.worldToScreen(p);
+                const std::string at = " at zoom " + std::to_string(zoom) + " for " + str(p);
+                check(near(camera.screenToWorld(s), p, 1e-3f * (1.0f + std::abs(x) + std::abs(y))),
+                    "screenToWorld(worldToScreen(p)) != p" + at, failures);
+                check(near(toScreen.apply(p), s, 1e-3f * (1.0f + std::abs(s.x) + std::abs(s.y))),
+                    "transform() != worldToScreen" + at, failures);
+                check(near(toWorld.apply(s), camera.screenToWorld(s), 1e-3f * (1.0f + std::abs(x) + std::abs(y))),
+                    "transform().inverse() != screenToWorld" + at, failures);
+            }
+    }
+
+    // the world under the cursor stays under it while zooming, panning moves everything by the offset
+    {
+        Camera2D camera(800.0f, 600.0f);
+        const Vector2 cursor{ 620.0f, 110.0f };
+        const Vector2 anchor = camera.screenToWorld(cursor);
+        for(int i = 0; i < 40; i++) {
+            camera.zoomAt(1.25f, cursor);
+            check(near(camera.worldToScreen(anchor), cursor, 1e-2f), "zoomAt moved the anchor, zoom " + std::to_string(camera.zoom), failures);
+        }
+        check(camera.zoom == camera.maxZoom, "zoomAt did not clamp to maxZoom", failures);
+
+        const Vector2 p{ 37.0f, -12.0f };
+        const Vector2 before = camera.worldToScreen(p);
+        camera.pan(15.0f, -40.0f);
+        check(near(camera.worldToScreen(p), before + Vector2{ 15.0f, -40.0f }, 1e-2f), "pan did not move the screen by its offset", failures);
+    }
+
+    // the view box is the viewport corners in world space, grown by margin / zoom
+    Camera2D camera(800.0f, 600.0f);
+    camera.center = { 1000.0f, 1000.0f };
+    camera.zoom = 2.0f;
+    const AABB view = camera.visibleBounds();
+    check(near(view.min, camera.screenToWorld({ 0.0f, 0.0f }), 1e-4f) && near(view.max, camera.screenToWorld({ 800.0f, 600.0f }), 1e-4f),
+        "visibleBounds() " + str(view.min) + " " + str(view.max) + " is not the viewport", failures);
+    check(near(view.min, { 800.0f, 850.0f }, 1e-4f) && near(view.max, { 1200.0f, 1150.0f }, 1e-4f),
+        "visibleBounds() " + str(view.min) + " " + str(view.max) + " is not the expected box", failures);
+    const AABB grown = camera.visibleBounds(10.0f);
+    check(near(grown.min, view.min - Vector2{ 5.0f, 5.0f }, 1e-4f) && near(grown.max, view.max + Vector2{ 5.0f, 5.0f }, 1e-4f),
+        "visibleBounds(10) is not grown by 10 / zoom", failures);
+
+    // drawVisible grows the view by 1 pixel, half a world unit here: boxes up to that far
+    // outside are drawn, boxes further out are culled
+    struct Placed { float x, y; bool drawn; const char* where; };
+    const Placed boxes[] = {
+        { 1000.0f, 1000.0f, true, "in the middle" },
+        { 1200.0f, 1000.0f, true, "across the right edge" },
+        { 1000.0f, 844.5f, true, "touching the grown top edge" },
+        { 794.5f, 1000.0f, true, "touching the grown left edge" },
+        { 794.0f, 1000.0f, false, "half a unit beyond the grown left edge" },
+        { 1000.0f, 1160.0f, false, "below the bottom edge" },
+        { 1205.6f, 1155.6f, false, "past the bottom right corner" },
+        { 795.0f, 845.0f, true, "on the top left corner" },
+    };
+
+    World world;
+    std::vector<bool> expected;
+    for(const auto& b: boxes) {
+        addStaticBox(world, b.x, b.y, 10.0f, 10.0f);
+        expected.push_back(b.drawn);
+    }
+    RigidBody ball;
+    ball.radius = 4.0f;
+    ball.pos = { 1198.0f, 849.0f };     // across the top right corner
+    world.add(ball);
+    expected.push_back(true);
+    world.step(1.0f / 60.0f);
+
+    DrawList list;
+    const size_t count = drawVisible(world, camera, list);
+    size_t expectedCount = 0;
+    for(bool drawn: expected)
+        expectedCount += drawn;
+    check(count == expectedCount && list.size() == expectedCount,
+        "drawVisible drew " + std::to_string(count) + " bodies, expected " + std::to_string(expectedCount), failures);
+
+    // every command is in screen space and belongs to a body that should be seen
+    std::vector<bool> drawn(world.bodies.size(), false);
+    const auto& vertices = list.getVertices();
+    for(const auto& c: list.getCommands())
+    {
+        if(c.type == DrawPrimitive::Circle) {
+            check(near({ c.x1, c.y1 }, camera.worldToScreen(ball.pos), 1e-3f) && std::abs(c.x2 - ball.radius * camera.zoom) < 1e-4f,
+                "ball drawn at " + str({ c.x1, c.y1 }) + " radius " + std::to_string(c.x2), failures);
+            drawn.back() = true;
+            continue;
+        }
+        for(size_t i = 0; i < std::size(boxes); i++)
+            if(near(vertices[c.first], camera.worldToScreen(world.bodies[i].transformed[0]), 1e-3f))
+                drawn[i] = true;
+    }
+    for(size_t i = 0; i < std::size(boxes); i++)
+        check(drawn[i] == boxes[i].drawn, std::string("box ") + boxes[i].where + (boxes[i].drawn ? " was culled" : " was drawn"), failures);
+    check(drawn.back(), "ball across the top right corner was culled", failures);
+
+    return failures;
+}
+
+
+std::string testTransform()
+{
+    std::string failures;
+    const Affine2 identity;
+
+    // inverse undoes the transform from either side
+    const Affine2 transforms[] = {
+        Affine2::translation(12.0f, -7.5f),
+        Affine2::scaling(3.0f, 0.25f),
+        Affine2::rotation(33.0f),
+        Affine2::translation(-40.0f, 8.0f) * Affine2::rotation(-120.0f) * Affine2::scaling(0.5f, 2.0f),
+        Affine2::ortho(800.0f, 600.0f),
+        Affine2{ 1.0f, 2.0f, 0.5f, 3.0f, 4.0f, -1.0f },    // sheared
+    };
+    for(size_t i = 0; i < std::size(transforms); i++)
+    {
+        const Affine2& m = transforms[i];
+        const Affine2 inv = m.inverse();
+        const std::string which = " for transform " + std::to_string(i);
+        check(near(m * inv, identity, 1e-5f) && near(inv * m, identity, 1e-5f), "m * m.inverse() is not the identity" + which, failures);
+        for(const Vector2 p: { Vector2{ 0.0f, 0.0f }, Vector2{ 100.0f, -250.0f }, Vector2{ -3.5f, 0.125f } })
+            check(near(inv.apply(m.apply(p)), p, 1e-3f), "inverse().apply(apply(p)) != p" + which + " at " + str(p), failures);
+    }
+    check(near(Affine2::scaling(0.0f, 2.0f).inverse(), identity, 0.0f), "singular inverse is not the identity", failures);
+
+    // a * b applies b first, and TransformStack::multiply post multiplies like Canvas2d::translate
+    const Affine2 t = Affine2::translation(10.0f, 0.0f), s = Affine2::scaling(2.0f, 2.0f);
+    const Vector2 p{ 1.0f, 1.0f };
+    check(near((t * s).apply(p), { 12.0f, 2.0f }, 1e-6f), "translation * scaling does not scale first", failures);
+    check(near((s * t).apply(p), { 22.0f, 2.0f }, 1e-6f), "scaling * translation does not translate first", failures);
+    for(size_t i = 0; i + 1 < std::size(transforms); i++)
+    {
+        const Affine2& a = transforms[i];
+        const Affine2& b = transforms[i + 1];
+        check(near((a * b).apply(p), a.apply(b.apply(p)), 1e-3f), "(a * b).apply(p) != a.apply(b.apply(p)) for transform " + std::to_string(i), failures);
+    }
+    TransformStack<4> order;
+    order.reset(t);
+    order.multiply(s);
+    check(near(order.current(), t * s, 0.0f), "TransformStack::multiply does not post multiply", failures);
+
+    // a stack of 4 levels pushed 6 deep: 2 pushes overflow and every pop still pairs with its push
+    TransformStack<4> stack;
+    stack.reset(identity);
+    Affine2 saved[4];
+    saved[0] = stack.current();
+    for(int level = 1; level < 4; level++) {
+        check(stack.push(), "push " + std::to_string(level) + " failed below capacity", failures);
+        stack.multiply(Affine2::translation(level, 0.0f));
+        saved[level] = stack.current();
+    }
+    check(!stack.push() && !stack.push(), "push succeeded past capacity", failures);
+    check(stack.depth() == 3 && stack.overflow() == 2, "overflowed stack is at depth " + std::to_string(stack.depth())
+        + " with " + std::to_string(stack.overflow()) + " overflows, expected 3 and 2", failures);
+
+    stack.multiply(Affine2::scaling(5.0f, 5.0f));
+    const Affine2 top = stack.current();
+    check(stack.pop() && stack.pop(), "pop of an overflowed push failed", failures);
+    check(stack.depth() == 3 && stack.overflow() == 0 && near(stack.current(), top, 0.0f),
+        "popping an overflowed push changed the level", failures);
+
+    for(int level = 3; level > 0; level--) {
+        stack.multiply(Affine2::rotation(45.0f));
+        check(stack.pop(), "pop " + std::to_string(level) + " failed", failures);
+        check(near(stack.current(), saved[level - 1], 0.0f), "pop " + std::to_string(level) + " did not restore the saved transform", failures);
+    }
+    check(!stack.pop() && stack.depth() == 0, "pop succeeded on an empty stack", failures);
+
+    stack.push();
+    stack.push();
+    stack.push();
+    stack.push();
+    stack.reset(identity);
+    check(stack.depth() == 0 && stack.overflow() == 0, "reset kept levels or overflows", failures);
+
+    return failures;
+}
+
+
+void softwareFrame(SoftwareRenderer& renderer, const DrawList& outlines, unsigned int seed)
+{
+    std::mt19937 eng(seed);
+    std::uniform_real_distribution<float> x(-40.0f, renderer.getWidth() + 40.0f);
+    std::uniform_real_distribution<float> y(-40.0f, renderer.getHeight() + 40.0f);
+    std::uniform_real_distribution<float> size(1.0f, 60.0f);
+    std::uniform_real_distribution<float> alpha(0.2f, 1.0f);
+    auto color = [&]() { return static_cast<unsigned int>(eng() & 0xffffff); };
+
+    renderer.clear(0x202020);
+    for(int i = 0; i < 300; i++)
+        renderer.fillCircle(x(eng), y(eng), size(eng), color(), i % 3 ? 1.0f : alpha(eng));
+
+    for(int i = 0; i < 300; i++)
+        renderer.drawLine(x(eng), y(eng), x(eng), y(eng), color(), i % 2 ? 1.0f : alpha(eng));
+
+    for(int i = 0; i < 100; i++)
+    {
+        int sides;
+        float radius;
+        auto vertices = randomPolygon(eng, sides, radius);
+        const Vector2 center{ x(eng), y(eng) };
+        for(auto& v: vertices)
+            v = center + v;
+        renderer.fillPolygon(vertices.data(), vertices.size(), color(), alpha(eng));
+    }
+
+    renderer.submit(outlines);
+    renderer.flush();
+}
+
+uint64_t hashFramebuffer(const SoftwareRenderer& renderer)
+{
+    return fnv1a(renderer.pixels(), sizeof(uint32_t) * renderer.getWidth() * renderer.getHeight());
+}
+
+
+std::string testSoftware()
+{
+    std::string failures;
+    const int width = 640, height = 480;
+    const unsigned int seed = 2026;
+
+    DrawList outlines;
+    for(int i = 0; i < 20; i++)
+        outlines.circleOutline(32.0f * i, 15.0f * i + 100.0f, 4.0f + 3.0f * i, 0xffffff, i % 2 ? 1.0f : 0.5f);
+
+    SoftwareRenderer reference(width, height, 64, 1);
+    softwareFrame(reference, outlines, seed);
+    const uint64_t hash = hashFramebuffer(reference);
+
+    auto compare = [&](SoftwareRenderer& renderer, const std::string& what) {
+        softwareFrame(renderer, outlines, seed);
+        if(!std::equal(reference.pixels(), reference.pixels() + width * height, renderer.pixels())) {
+            size_t i = std::mismatch(reference.pixels(), reference.pixels() + width * height, renderer.pixels()).first - reference.pixels();
+            std::ostringstream at;
+            at << what << " differs from 1 thread first at pixel " << i % width << ", " << i / width;
+            check(false, at.str(), failures);
+        }
+    };
+
+    // tiles of any size rasterized in any order by any thread give the same pixels
+    for(unsigned int threads: { 1u, 2u, 4u, 7u })
+        for(int tile: { 16, 64, 100, 640 })
+        {
+            SoftwareRenderer renderer(width, height, tile, threads);
+            compare(renderer, std::to_string(threads) + " threads with " + std::to_string(tile) + " pixel tiles");
+        }
+
+    JobSystem jobs(3);
+    SoftwareRenderer onJobs(width, height, 32);
+    onJobs.setJobSystem(&jobs);
+    compare(onJobs, "a JobSystem of 3 threads");
+
+    // a second frame on the same renderer must not depend on the first
+    compare(onJobs, "the second frame of a renderer");
+
+    if(!recordPath.empty())
+    {
+        std::ofstream out(recordPath);
+        out << "# render_test software frame " << width << "x" << height << " seed " << seed << std::endl;
+        out << std::hex << std::setw(16) << std::setfill('0') << hash << std::endl;
+        check(bool(out), "unable to write " + recordPath, failures);
+    }
+
+    if(!goldenPath.empty())
+    {
+        std::ifstream in(goldenPath);
+        std::string line;
+        while(std::getline(in, line) && (line.empty() || line[0] == '#'))
+            ;
+        uint64_t expected = 0;
+        std::istringstream(line) >> std::hex >> expected;
+        std::ostringstream got;
+        got << std::hex << std::setw(16) << std::setfill('0') << hash;
+        check(in && expected == hash, "frame hash " + got.str() + " does not match " + goldenPath, failures);
+    }
+
+    return failures;
+}
@@ -0,0 +1,679 @@
+/**
+ * @file satFuzz/main.cpp
+ * @brief differential fuzzing of the collision kernels against the reference SAT
+ * @date 18th Oct, 2026
+ *
+ * Generates random convex polygons (the SAT_test ones, random cyclic
+ * polygons, hulls of random points and slivers, in both windings) and
+ * places the pairs apart, overlapping or a hair from touching. Every kernel
+ * is run next to satCollision of SAT.h and the answers are compared.
+ *
+ * The swept kernels fire a fast ball from outside b straight through it, at
+ * b as a polygon and at one of its edges as a zero thickness wall, and fail
+ * if the path of the ball over the step crosses the obstacle. The bullet
+ * kernels do the same with integrateBodies: a as a polygon bullet or a ball
+ * bullet, fired at b or at a ball in its place. A bullet that already overlaps
+ * the obstacle bounces at once if it moves deeper, and either way must not
+ * stop: with a restitution of 1 it covers its whole step.
+ *
+ * Pairs closer to touching than the tolerance, measured in double precision,
+ * may go either way and are not compared. A mismatch is shrunk to a small
+ * reproducer (fewer vertices, rounded coordinates) printed as code.
+ *
+ *  sat_fuzz [--iterations N] [--seed N] [--tolerance relative] [--kernel substring]
+ *           [--reproducers N]
+ */
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <phy/Vector.h>
+#include <phy/SAT.h>
+#include <phy/Narrowphase.h>
+#include <phy/Broadphase.h>
+#include <phy/TimeOfImpact.h>
+#include <phy/Sweep.h>
+
+using namespace phy;
+
+
+struct Case
+{
+    std::vector<Vector2> a;     // world space vertices
+    std::vector<Vector2> b;
+};
+
+
+/// @brief What the reference says about a case
+struct Reference
+{
+    bool overlap;       // satCollision
+    double gap;         // > 0 separation along the best axis, < 0 least penetration
+    double scale;       // largest extent of the two polygons
+};
+
+
+struct Kernel
+{
+    const char* name;
+    /// @return an empty string if the kernel agrees with the reference
+    std::string (*check)(const Case& c, const Reference& ref, double tolerance);
+};
+
+
+/// @brief Signed distance of the pair along its best separating axis, in double
+double separation(const std::vector<Vector2>& a, const std::vector<Vector2>& b);
+
+Reference reference(const Case& c);
+
+/// @brief Vertices of a random convex polygon of one of the generator kinds, centered on the origin
+std::vector<Vector2> randomConvex(std::mt19937& eng);
+
+/// @brief Random pair, overlapping, apart or about touching
+Case randomCase(std::mt19937& eng, double tolerance);
+
+/// @brief Shrink a failing case while the kernel still fails on it
+Case minimize(const Kernel& kernel, Case c, double tolerance);
+
+std::string reproducer(const Kernel& kernel, const Case& c);
+
+
+std::string checkSatSymmetry(const Case& c, const Reference& ref, double tolerance);
+std::string checkSatExact(const Case& c, const Reference& ref, double tolerance);
+std::string checkCollidePolygons(const Case& c, const Reference& ref, double tolerance);
+std::string checkPolygonsOverlap(const Case& c, const Reference& ref, double tolerance);
+std::string checkPolygonDistance(const Case& c, const Reference& ref, double tolerance);
+std::string checkBounds(const Case& c, const Reference& ref, double tolerance);
+std::string checkAdvanceBallPolygon(const Case& c, const Reference& ref, double tolerance);
+std::string checkAdvanceBallWall(const Case& c, const Reference& ref, double tolerance);
+std::string checkBulletPolygon(const Case& c, const Reference& ref, double tolerance);
+std::string checkBulletBall(const Case& c, const Reference& ref, double tolerance);
+std::string checkBallBulletPolygon(const Case& c, const Reference& ref, double tolerance);
+std::string checkBulletOverlapping(const Case& c, const Reference& ref, double tolerance);
+
+const Kernel kernels[] = {
+    { "satCollision symmetry", checkSatSymmetry },
+    { "satCollision exact", checkSatExact },
+    { "collidePolygons", checkCollidePolygons },
+    { "polygonsOverlap", checkPolygonsOverlap },
+    { "polygonDistance", checkPolygonDistance },
+    { "AABB", checkBounds },
+    { "advanceBall polygon", checkAdvanceBallPolygon },
+    { "advanceBall wall", checkAdvanceBallWall },
+    { "bullet polygon", checkBulletPolygon },
+    { "bullet ball", checkBulletBall },
+    { "ball bullet polygon", checkBallBulletPolygon },
+    { "bullet overlapping", checkBulletOverlapping },
+};
+
+
+int main(int argc, char** argv)
+{
+    long iterations = 200000;
+    unsigned int seed = 1;
+    double tolerance = 1e-4;
+    std::string filter;
+    int maxReproducers = 3;
+
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if(arg == "--iterations") iterations = std::atol(argv[i + 1]);
+        else if(arg == "--seed") seed = std::strtoul(argv[i + 1], nullptr, 10);
+        else if(arg == "--tolerance") tolerance = std::atof(argv[i + 1]);
+        else if(arg == "--kernel") filter = argv[i + 1];
+        else if(arg == "--reproducers") maxReproducers = std::atoi(argv[i + 1]);
+        else {
+            std::cerr << "usage: sat_fuzz [--iterations N] [--seed N] [--tolerance relative] "
+                "[--kernel substring] [--reproducers N]" << std::endl;
+            return 1;
+        }
+    }
+    if(argc % 2 == 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << std::endl;
+        return 1;
+    }
+
+    std::vector<const Kernel*> selected;
+    for(const auto& k: kernels)
+        if(filter.empty() || std::string(k.name).find(filter) != std::string::npos)
+            selected.push_back(&k);
+
+    std::vector<long> mismatches(selected.size(), 0);
+    std::vector<std::string> reports(selected.size());
+    long overlapping = 0, near = 0;
+
+    std::mt19937 eng(seed);
+    for(long i = 0; i < iterations; i++)
+    {
+        const Case c = randomCase(eng, tolerance);
+        const Reference ref = reference(c);
+        overlapping += ref.overlap;
+
+        // closer to touching than the tolerance: either answer is right
+        if(std::abs(ref.gap) <= tolerance * ref.scale) {
+            near++;
+            continue;
+        }
+
+        for(size_t k = 0; k < selected.size(); k++)
+        {
+            std::string why = selected[k]->check(c, ref, tolerance);
+            if(why.empty())
+                continue;
+            if(mismatches[k]++ < maxReproducers)
+                reports[k] += "  case " + std::to_string(i) + ": " + why + "\n" +
+                    reproducer(*selected[k], minimize(*selected[k], c, tolerance));
+        }
+    }
+
+    std::cout << iterations << " cases, seed " << seed << ", " << overlapping << " overlapping, "
+        << near << " within tolerance of touching skipped" << std::endl;
+
+    bool failed = false;
+    for(size_t k = 0; k < selected.size(); k++)
+    {
+        std::cout << std::left << std::setw(24) << selected[k]->name << std::right << std::setw(10)
+            << mismatches[k] << " mismatches" << std::endl;
+        std::cout << reports[k];
+        failed = failed || mismatches[k] > 0;
+    }
+    return failed ? 1 : 0;
+}
+
+
+double separation(const std::vector<Vector2>& a, const std::vector<Vector2>& b)
+{
+    double best = -INFINITY;
+    for(int pass = 0; pass < 2; pass++)
+    {
+        const auto& p = pass == 0 ? a : b;
+        const auto& q = pass == 0 ? b : a;
+        for(size_t i = 0; i < p.size(); i++)
+        {
+            const auto& v1 = p[i];
+            const auto& v2 = p[(i + 1) % p.size()];
+            double nx = (double)v2.y - v1.y, ny = (double)v1.x - v2.x;
+            double length = std::sqrt(nx * nx + ny * ny);
+            if(length == 0.0)
+                continue;
+            nx /= length;
+            ny /= length;
+
+            double minP = INFINITY, maxP = -INFINITY, minQ = INFINITY, maxQ = -INFINITY;
+            for(const auto& v: p) {
+                double d = v.x * nx + v.y * ny;
+                minP = std::min(minP, d);
+                maxP = std::max(maxP, d);
+            }
+            for(const auto& v: q) {
+                double d = v.x * nx + v.y * ny;
+                minQ = std::min(minQ, d);
+                maxQ = std::max(maxQ, d);
+            }
+            best = std::max(best, std::max(minQ - maxP, minP - maxQ));
+        }
+    }
+    return best;
+}
+
+
+Reference reference(const Case& c)
+{
+    double lo[2] = { INFINITY, INFINITY }, hi[2] = { -INFINITY, -INFINITY };
+    for(const auto* poly: { &c.a, &c.b })
+        for(const auto& v: *poly) {
+            lo[0] = std::min(lo[0], (double)v.x);
+            lo[1] = std::min(lo[1], (double)v.y);
+            hi[0] = std::max(hi[0], (double)v.x);
+            hi[1] = std::max(hi[1], (double)v.y);
+        }
+    return { satCollision(c.a, c.b), separation(c.a, c.b), std::max({ hi[0] - lo[0], hi[1] - lo[1], 1.0 }) };
+}
+
+
+std::vector<Vector2> randomConvex(std::mt19937& eng)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Vector2> v;
+
+    switch(eng() % 4)
+    {
+        case 0: {
+            // the polygons of SAT_test
+            int sides;
+            float radius;
+            v = randomPolygon(eng, sides, radius);
+            break;
+        }
+        case 1: {
+            // sorted angles on a circle always make a convex polygon
+            const int n = 3 + eng() % 10;
+            const float r = 5.0f + unit(eng) * 60.0f;
+            std::vector<float> angles(n);
+            for(auto& a: angles)
+                a = unit(eng) * 2.0f * 3.14159265f;
+            std::sort(angles.begin(), angles.end());
+            for(float a: angles)
+                v.push_back({ std::cos(a) * r, std::sin(a) * r });
+            break;
+        }
+        case 2: {
+            // convex hull of random points in an ellipse (monotone chain)
+            const int n = 4 + eng() % 20;
+            const float rx = 5.0f + unit(eng) * 60.0f, ry = 5.0f + unit(eng) * 60.0f;
+            std::vector<Vector2> points(n);
+            for(auto& p: points)
+                p = { (unit(eng) * 2 - 1) * rx, (unit(eng) * 2 - 1) * ry };
+            std::sort(points.begin(), points.end(), [](const Vector2& p, const Vector2& q) {
+                return p.x < q.x || (p.x == q.x && p.y < q.y);
+            });
+            auto cross = [](const Vector2& o, const Vector2& p, const Vector2& q) {
+                return (p.x - o.x) * (q.y - o.y) - (p.y - o.y) * (q.x - o.x);
+            };
+            std::vector<Vector2> hull(2 * n);
+            int k = 0;
+            for(int i = 0; i < n; i++) {
+                while(k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+                hull[k++] = points[i];
+            }
+            for(int i = n - 2, t = k + 1; i >= 0; i--) {
+                while(k >= t && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+                hull[k++] = points[i];
+            }
+            hull.resize(k - 1);
+            v = hull.size() >= 3 ? hull : std::vector<Vector2>{ { -rx, -ry }, { rx, -ry }, { 0.0f, ry } };
+            break;
+        }
+        default: {
+            // slivers: long thin boxes and triangles
+            const float length = 10.0f + unit(eng) * 100.0f, width = 0.2f + unit(eng) * 3.0f;
+            if(eng() % 2)
+                v = { { -length / 2, -width / 2 }, { length / 2, -width / 2 }, { length / 2, width / 2 }, { -length / 2, width / 2 } };
+            else
+                v = { { -length / 2, 0.0f }, { length / 2, -width / 2 }, { length / 2, width / 2 } };
+            break;
+        }
+    }
+
+    // the kernels must not depend on the winding
+    if(eng() % 2)
+        std::reverse(v.begin(), v.end());
+    return v;
+}
+
+
+Case randomCase(std::mt19937& eng, double tolerance)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const auto localA = randomConvex(eng);
+    const auto localB = randomConvex(eng);
+
+    Case c;
+    const Vector2 posA{ (unit(eng) * 2 - 1) * 500.0f, (unit(eng) * 2 - 1) * 500.0f };
+    transformVertices(localA, posA, unit(eng) * 360.0f, c.a);
+
+    const float rotationB = unit(eng) * 360.0f;
+    const float angle = unit(eng) * 2.0f * 3.14159265f;
+    const Vector2 dir{ std::cos(angle), std::sin(angle) };
+    const float reach = boundingRadius(localA) + boundingRadius(localB);
+
+    if(eng() % 3 != 0) {
+        // anywhere from on top of each other to just out of reach
+        transformVertices(localB, posA + dir * (reach * unit(eng) * 1.1f), rotationB, c.b);
+        return c;
+    }
+
+    // about touching: find the contact distance along dir, then step a few
+    // tolerances in or out so the case is still compared
+    float lo = 0.0f, hi = reach * 1.01f;
+    for(int i = 0; i < 40; i++) {
+        float mid = (lo + hi) * 0.5f;
+        transformVertices(localB, posA + dir * mid, rotationB, c.b);
+        (separation(c.a, c.b) > 0.0 ? hi : lo) = mid;
+    }
+    const float offset = (float)(tolerance * reach * (2.0 + unit(eng) * 8.0)) * (eng() % 2 ? 1.0f : -1.0f);
+    transformVertices(localB, posA + dir * (lo + offset), rotationB, c.b);
+    return c;
+}
+
+
+Case minimize(const Kernel& kernel, Case c, double tolerance)
+{
+    auto fails = [&](const Case& t) {
+        Reference ref = reference(t);
+        return std::abs(ref.gap) > tolerance * ref.scale && !kernel.check(t, ref, tolerance).empty();
+    };
+
+    for(bool progress = true; progress;)
+    {
+        progress = false;
+
+        // fewer vertices, a convex polygon without a vertex is still convex
+        for(auto* poly: { &c.a, &c.b })
+            for(size_t i = 0; poly->size() > 3 && i < poly->size();)
+            {
+                Case t = c;
+                auto& p = poly == &c.a ? t.a : t.b;
+                p.erase(p.begin() + i);
+                if(fails(t)) {
+                    c = t;
+                    progress = true;
+                }
+                else i++;
+            }
+
+        // move the pair next to the origin
+        {
+            Case t = c;
+            Vector2 shift{ std::round(c.a[0].x), std::round(c.a[0].y) };
+            for(auto& v: t.a) v -= shift;
+            for(auto& v: t.b) v -= shift;
+            if((shift.x != 0.0f || shift.y != 0.0f) && fails(t)) {
+                c = t;
+                progress = true;
+            }
+        }
+
+        // shorter coordinates, coarsest rounding first
+        for(double unit: { 1.0, 0.1, 0.01, 0.001 })
+        {
+            Case t = c;
+            for(auto* p: { &t.a, &t.b })
+                for(auto& v: *p)
+                    v = { (float)(std::round(v.x / unit) * unit), (float)(std::round(v.y / unit) * unit) };
+            bool changed = false;
+            for(size_t i = 0; i < c.a.size(); i++) changed = changed || !(t.a[i].x == c.a[i].x && t.a[i].y == c.a[i].y);
+            for(size_t i = 0; i < c.b.size(); i++) changed = changed || !(t.b[i].x == c.b[i].x && t.b[i].y == c.b[i].y);
+            if(changed && fails(t)) {
+                c = t;
+                progress = true;
+                break;
+            }
+        }
+    }
+    return c;
+}
+
+
+std::string reproducer(const Kernel& kernel, const Case& c)
+{
+    auto list = [](const std::vector<Vector2>& p) {
+        std::ostringstream out;
+        out << std::setprecision(9) << "{ ";
+        for(size_t i = 0; i < p.size(); i++)
+            out << (i ? ", " : "") << "{ " << p[i].x << "f, " << p[i].y << "f }";
+        out << " }";
+        return out.str();
+    };
+
+    const Reference ref = reference(c);
+    std::ostringstream out;
+    out << "    // " << kernel.name << ": " << kernel.check(c, ref, 0.0) << ", gap " << ref.gap << "\n"
+        << "    std::vector<Vector2> a = " << list(c.a) << ";\n"
+        << "    std::vector<Vector2> b = " << list(c.b) << ";\n";
+    return out.str();
+}
+
+
+Shape shapeOf(const std::vector<Vector2>& v)
+{
+    Vector2 center;
+    for(const auto& p: v)
+        center += p;
+    return polygonShape(center * (1.0f / v.size()), v);
+}
+
+
+std::string checkSatSymmetry(const Case& c, const Reference& ref, double)
+{
+    if(satCollision(c.b, c.a) != ref.overlap)
+        return "satCollision(b, a) differs from satCollision(a, b)";
+    return "";
+}
+
+
+std::string checkSatExact(const Case&, const Reference& ref, double)
+{
+    if(ref.overlap != (ref.gap <= 0.0))
+        return ref.overlap ? "overlap, the exact gap is positive" : "no overlap, the exact gap is negative";
+    return "";
+}
+
+
+std::string checkCollidePolygons(const Case& c, const Reference& ref, double tolerance)
+{
+    Manifold m;
+    const bool hit = collidePolygons(shapeOf(c.a), shapeOf(c.b), m);
+    if(hit != ref.overlap)
+        return hit ? "collision where satCollision sees none" : "no collision where satCollision sees one";
+    if(!hit)
+        return "";
+
+    // the manifold: a unit normal and no deeper than the reference face allows
+    if(std::abs(m.normal.getLength() - 1.0f) > 1e-3f)
+        return "normal is not unit length";
+    if(m.depth < 0.0f || m.depth > -ref.gap / 0.98 + 0.002 + tolerance * ref.scale)
+        return "depth " + std::to_string(m.depth) + " outside [0, " + std::to_string(-ref.gap) + "]";
+    return "";
+}
+
+
+std::string checkPolygonsOverlap(const Case& c, const Reference& ref, double)
+{
+    if(polygonsOverlap(c.a, c.b) != ref.overlap)
+        return ref.overlap ? "no overlap where satCollision sees one" : "overlap where satCollision sees none";
+    return "";
+}
+
+
+std::string checkPolygonDistance(const Case& c, const Reference& ref, double tolerance)
+{
+    Vector2 normal;
+    const float d = polygonDistance(c.a, c.b, normal);
+    if((d == 0.0f) != ref.overlap)
+        return "distance " + std::to_string(d) + (ref.overlap ? " for overlapping polygons" : " for separated polygons");
+
+    // a separating axis gap never exceeds the distance
+    if(!ref.overlap && d < ref.gap - tolerance * ref.scale)
+        return "distance " + std::to_string(d) + " below the separating gap " + std::to_string(ref.gap);
+    return "";
+}
+
+
+std::string checkBounds(const Case& c, const Reference& ref, double)
+{
+    auto box = [](const std::vector<Vector2>& v) {
+        AABB b{ { INFINITY, INFINITY }, { -INFINITY, -INFINITY } };
+        for(const auto& p: v) {
+            b.min = { std::min(b.min.x, p.x), std::min(b.min.y, p.y) };
+            b.max = { std::max(b.max.x, p.x), std::max(b.max.y, p.y) };
+        }
+        return b;
+    };
+
+    // the broadphase may report pairs that do not touch but never miss one
+    if(ref.overlap && !box(c.a).overlaps(box(c.b)))
+        return "bounding boxes apart for overlapping polygons";
+    return "";
+}
+
+
+Vector2 centroid(const std::vector<Vector2>& v)
+{
+    Vector2 center;
+    for(const auto& p: v)
+        center += p;
+    return center * (1.0f / v.size());
+}
+
+
+/// @brief A ball started outside an obstacle and moving through target, far enough to leave it behind in one step
+Ball shoot(const Case& c, const std::vector<Vector2>& obstacle, const Vector2& target, Vector2 dir)
+{
+    Ball ball;
+    ball.radius = 1 + static_cast<int>(c.a.size() % 5);
+
+    float extent = 0.0f;
+    for(const auto& v: obstacle)
+        extent = std::max(extent, (v - target).getLength());
+    ball.pos = target - dir * (extent + ball.radius + 1.0f);
+    ball.vel = dir * (2.0f * (extent + ball.radius) + 100.0f);
+    return ball;
+}
+
+
+std::string checkAdvanceBallPolygon(const Case& c, const Reference&, double)
+{
+    // aim halfway between the center of b and one of its corners, from the side of a
+    const Vector2 target = (centroid(c.b) + c.b[c.a.size() % c.b.size()]) * 0.5f;
+    Vector2 dir = target - centroid(c.a);
+    if(dir.getLength() < 1e-3f)
+        dir = { 1.0f, 0.0f };
+    Ball ball = shoot(c, c.b, target, dir.normalize());
+
+    const Vector2 start = ball.pos;
+    advanceBall(ball, 1.0f, {}, { c.b });
+    if(separation({ start, ball.pos }, c.b) <= 0.0)
+        return "the ball went into or through the polygon";
+    return "";
+}
+
+
+std::string checkAdvanceBallWall(const Case& c, const Reference&, double)
+{
+    // one edge of b as a wall without thickness, hit at its middle
+    const Wall wall{ c.b[0], c.b[1] };
+    Vector2 along = wall.end - wall.start;
+    if(along.getLength() < 1e-3f)
+        return "";
+    along.normalize();
+    const Vector2 normal{ along.y, -along.x };
+
+    // from the side of a, but not so flat that a corner takes the hit
+    Vector2 dir = wall.start * 0.5f + wall.end * 0.5f - centroid(c.a);
+    if(dir.getLength() < 1e-3f || std::abs(dir.dotProduct(normal)) < 0.3f * dir.getLength())
+        dir = normal;
+    const std::vector<Vector2> segment{ wall.start, wall.end };
+    Ball ball = shoot(c, segment, wall.start * 0.5f + wall.end * 0.5f, dir.normalize());
+
+    const Vector2 start = ball.pos;
+    advanceBall(ball, 1.0f, { wall });
+    if(separation({ start, ball.pos }, segment) <= 0.0)
+        return "the ball crossed the wall";
+    return "";
+}
+
+
+/// @brief Body with the world space vertices of v around their centroid
+RigidBody polygonBody(const std::vector<Vector2>& v)
+{
+    RigidBody body;
+    body.pos = centroid(v);
+    for(const auto& p: v)
+        body.vertices.push_back(p - body.pos);
+    transformVertices(body.vertices, body.pos, 0.0f, body.transformed);
+    return body;
+}
+
+
+RigidBody ballBody(const Vector2& center, float radius)
+{
+    RigidBody body;
+    body.pos = center;
+    body.radius = radius;
+    return body;
+}
+
+
+/// @brief Fire bullet from outside the static obstacle through target for one step
+/// @return an empty string if the path of the bullet center stays clear of the obstacle
+std::string fireBullet(RigidBody bullet, RigidBody obstacle, const Vector2& target, Vector2 dir)
+{
+    if(dir.getLength() < 1e-3f)
+        dir = { 1.0f, 0.0f };
+    dir.normalize();
+
+    float extent = obstacle.radius + (obstacle.pos - target).getLength();
+    for(const auto& v: obstacle.transformed)
+        extent = std::max(extent, (v - target).getLength());
+    const float r = bodyRadius(bullet);
+
+    bullet.isBullet = true;
+    bullet.pos = target - dir * (extent + r + 1.0f);
+    bullet.vel = dir * (2.0f * (extent + r) + 100.0f);
+    obstacle.mass = 0.0f;
+
+    std::vector<RigidBody> bodies{ bullet, obstacle };
+    const Vector2 start = bullet.pos;
+    integrateBodies(bodies, 1.0f);
+    const Vector2 end = bodies[0].pos;
+
+    if(obstacle.vertices.empty()) {
+        Vector2 closest;
+        if(pointSegmentDistance(obstacle.pos, start, end, closest) <= obstacle.radius)
+            return "the bullet went into or through the ball";
+    }
+    else if(separation({ start, end }, obstacle.transformed) <= 0.0)
+        return "the bullet went into or through the polygon";
+    return "";
+}
+
+
+std::string checkBulletPolygon(const Case& c, const Reference&, double)
+{
+    const Vector2 target = (centroid(c.b) + c.b[c.a.size() % c.b.size()]) * 0.5f;
+    return fireBullet(polygonBody(c.a), polygonBody(c.b), target, target - centroid(c.a));
+}
+
+
+std::string checkBulletBall(const Case& c, const Reference&, double)
+{
+    const Vector2 center = centroid(c.b);
+    const float radius = 1.0f + boundingRadius(polygonBody(c.b).vertices) * 0.5f;
+    return fireBullet(polygonBody(c.a), ballBody(center, radius), center, center - centroid(c.a));
+}
+
+
+std::string checkBallBulletPolygon(const Case& c, const Reference&, double)
+{
+    const Vector2 target = (centroid(c.b) + c.b[c.a.size() % c.b.size()]) * 0.5f;
+    const float radius = 1.0f + static_cast<float>(c.a.size() % 5);
+    return fireBullet(ballBody(centroid(c.a), radius), polygonBody(c.b), target, target - centroid(c.a));
+}
+
+
+std::string checkBulletOverlapping(const Case& c, const Reference& ref, double)
+{
+    if(!ref.overlap)
+        return "";
+
+    // deeper into b or along it, as a polygon and as a ball inside b
+    Vector2 dir = centroid(c.b) - centroid(c.a);
+    if(dir.getLength() < 1e-3f)
+        dir = { 1.0f, 0.0f };
+    dir.normalize();
+    if(c.b.size() % 2)
+        dir = { -dir.y, dir.x };
+
+    RigidBody obstacle = polygonBody(c.b);
+    obstacle.mass = 0.0f;
+    RigidBody bullets[] = { polygonBody(c.a), ballBody(centroid(c.b), 1.0f) };
+    for(auto& bullet: bullets)
+    {
+        bullet.isBullet = true;
+        bullet.vel = dir * 200.0f;
+        std::vector<RigidBody> bodies{ bullet, obstacle };
+        const float dt = 1.0f / 60.0f;
+        integrateBodies(bodies, dt);
+        if(std::abs((bodies[0].pos - bullet.pos).getLength() - bullet.vel.getLength() * dt) > 1e-3f)
+            return bullet.vertices.empty() ? "the ball bullet stopped inside the polygon" :
+                "the bullet stopped inside the polygon";
+    }
+    return "";
+}
@@ -0,0 +1,296 @@
+/**
+ * @file stressTest/main.cpp
+ * @brief scaling sweep of the scenarios of Scenario.h
+ * @date 18th Oct, 2026
+ *
+ * Runs every selected scenario for every body count and thread count and
+ * reports the step time percentiles, the throughput and the memory in use,
+ * so a change can be judged on how it scales and not on a single point.
+ * With N threads a JobSystem of N threads runs either the parallel phases
+ * of a single World (--mode jobs, how a step scales with the cores) or N
+ * independent worlds each stepping on one thread (--mode worlds, how well
+ * the step shares the machine). The results are printed as a table and
+ * written as JSON.
+ *
+ *  stress_test [--scenarios a,b,...] [--bodies 250,500,...] [--threads 1,2,...]
+ *              [--mode jobs|worlds] [--steps N] [--warmup N] [--dt seconds]
+ *              [--seed N] [--json path]
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <phy/World.h>
+#include <phy/JobSystem.h>
+#include <phy/Scenario.h>
+
+using namespace phy;
+
+
+struct Options
+{
+    std::vector<std::string> scenarios;     // empty runs the whole table
+    std::vector<int> bodies = { 250, 500, 1000, 2000 };
+    std::vector<int> threads = { 1, 2, 4 };
+    bool worlds = false;    // one world per thread instead of one world on every thread
+    int steps = 300;
+    int warmup = 30;        // steps run before timing, the bodies settle a little
+    float dt = 1.0f / 60.0f;
+    unsigned int seed = 1;
+    std::string json = "stress_test.json";
+};
+
+
+struct Run
+{
+    std::string scenario;
+    int bodies;             // requested dynamic bodies
+    size_t worldBodies;     // static ones included
+    int threads;
+    double mean, p50, p90, p99, max;    // ms per step
+    double stepsPerSecond;  // summed over the worlds
+    double exponent;        // log-log slope of p50 against the previous body count
+    long rssKb;             // resident memory after the run
+    long peakRssKb;
+};
+
+
+/// @brief Parse the command line
+/// @return false if an argument is unknown or malformed
+bool parseOptions(int argc, char** argv, Options& options);
+
+
+/// @brief Step one world on a job system of the given threads, or one world per thread
+Run runScenario(const Scenario& scenario, int bodies, int threads, const Options& options);
+
+
+/// @brief Resident set size in KB, 0 where /proc is missing
+long residentKb();
+
+
+/// @brief Peak resident set size of the process in KB
+long peakResidentKb();
+
+
+bool writeJson(const std::string& path, const std::vector<Run>& runs, const Options& options);
+
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if(!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: stress_test [--scenarios a,b,...] [--bodies 250,500,...] [--threads 1,2,...] "
+            "[--mode jobs|worlds] [--steps N] [--warmup N] [--dt seconds] [--seed N] [--json path]\n\nscenarios:";
+        for(const auto& s: scenarios)
+            std::cerr << " " << s.name;
+        std::cerr << std::endl;
+        return 1;
+    }
+
+    std::vector<const Scenario*> selected;
+    if(options.scenarios.empty()) {
+        for(const auto& s: scenarios)
+            selected.push_back(&s);
+    }
+    for(const auto& name: options.scenarios)
+    {
+        const Scenario* s = findScenario(name);
+        if(!s) {
+            std::cerr << "Unknown scenario " << name << std::endl;
+            return 1;
+        }
+        selected.push_back(s);
+    }
+
+    std::cout << std::left << std::setw(10) << "scenario" << std::right << std::setw(8) << "bodies"
+        << std::setw(8) << "threads" << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms"
+        << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::setw(11) << "steps/s"
+        << std::setw(8) << "slope" << std::setw(10) << "rss MB" << std::endl;
+
+    std::vector<Run> runs;
+    for(const Scenario* scenario: selected)
+    {
+        for(int threads: options.threads)
+        {
+            const Run* previous = nullptr;
+            for(int bodies: options.bodies)
+            {
+                Run r = runScenario(*scenario, bodies, threads, options);
+                if(previous && previous->p50 > 0.0 && r.p50 > 0.0)
+                    r.exponent = std::log(r.p50 / previous->p50) / std::log((double)r.bodies / previous->bodies);
+                runs.push_back(r);
+                previous = &runs.back();
+
+                std::cout << std::left << std::setw(10) << r.scenario << std::right << std::setw(8) << r.bodies
+                    << std::setw(8) << r.threads << std::fixed << std::setprecision(3)
+                    << std::setw(10) << r.p50 << std::setw(10) << r.p90 << std::setw(10) << r.p99
+                    << std::setw(10) << r.max << std::setprecision(0) << std::setw(11) << r.stepsPerSecond
+                    << std::setprecision(2) << std::setw(8) << r.exponent
+                    << std::setprecision(1) << std::setw(10) << r.rssKb / 1024.0 << std::endl;
+            }
+        }
+    }
+
+    if(!writeJson(options.json, runs, options)) {
+        std::cerr << "Unable to write " << options.json << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    auto splitInts = [](const std::string& list, std::vector<int>& out) {
+        out.clear();
+        std::stringstream ss(list);
+        for(std::string item; std::getline(ss, item, ',');)
+            out.push_back(std::atoi(item.c_str()));
+        return !out.empty() && std::all_of(out.begin(), out.end(), [](int v) { return v > 0; });
+    };
+
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if(arg == "--scenarios") {
+            options.scenarios.clear();
+            std::stringstream ss(value);
+            for(std::string item; std::getline(ss, item, ',');)
+                options.scenarios.push_back(item);
+        }
+        else if(arg == "--bodies") { if(!splitInts(value, options.bodies)) return false; }
+        else if(arg == "--threads") { if(!splitInts(value, options.threads)) return false; }
+        else if(arg == "--mode") {
+            if(value != "jobs" && value != "worlds")
+                return false;
+            options.worlds = value == "worlds";
+        }
+        else if(arg == "--steps") options.steps = std::atoi(value.c_str());
+        else if(arg == "--warmup") options.warmup = std::max(0, std::atoi(value.c_str()));
+        else if(arg == "--dt") options.dt = std::atof(value.c_str());
+        else if(arg == "--seed") options.seed = std::strtoul(value.c_str(), nullptr, 10);
+        else if(arg == "--json") options.json = value;
+        else return false;
+    }
+    return argc % 2 == 1 && options.steps > 0 && options.dt > 0.0f;
+}
+
+
+Run runScenario(const Scenario& scenario, int bodies, int threads, const Options& options)
+{
+    JobSystem jobs(threads);
+
+    // every world gets its own seed, otherwise the threads would run the same steps
+    const int worldCount = options.worlds ? threads : 1;
+    std::vector<World> worlds(worldCount);
+    for(int w = 0; w < worldCount; w++)
+        scenario.build(worlds[w], { bodies, options.seed + static_cast<unsigned int>(w) });
+    if(!options.worlds && threads > 1)
+        worlds[0].setJobSystem(&jobs);
+
+    std::vector<std::vector<double>> times(worldCount);
+    auto run = [&](int w) {
+        auto& world = worlds[w];
+        times[w].reserve(options.steps);
+        for(int i = 0; i < options.warmup; i++)
+            stepScenario(scenario, world, options.dt);
+        for(int i = 0; i < options.steps; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            stepScenario(scenario, world, options.dt);
+            times[w].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    jobs.parallelFor(worldCount, [&](size_t begin, size_t end, unsigned int) {
+        for(size_t w = begin; w < end; w++)
+            run(static_cast<int>(w));
+    }, 1);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for(const auto& t: times)
+        all.insert(all.end(), t.begin(), t.end());
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) { return all[std::min(all.size() - 1, (size_t)(p * all.size()))]; };
+
+    double total = 0.0;
+    for(double t: all)
+        total += t;
+
+    Run r;
+    r.scenario = scenario.name;
+    r.bodies = bodies;
+    r.worldBodies = worlds[0].bodies.size();
+    r.threads = threads;
+    r.mean = total / all.size();
+    r.p50 = percentile(0.5);
+    r.p90 = percentile(0.9);
+    r.p99 = percentile(0.99);
+    r.max = all.back();
+    r.stepsPerSecond = (double)worldCount * (options.warmup + options.steps) / wall;
+    r.exponent = 0.0;
+    r.rssKb = residentKb();
+    r.peakRssKb = peakResidentKb();
+    return r;
+}
+
+
+long residentKb()
+{
+    long pages = 0, resident = 0;
+    if(FILE* f = std::fopen("/proc/self/statm", "r")) {
+        if(std::fscanf(f, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        std::fclose(f);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+
+long peakResidentKb()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;     // already KB on Linux
+}
+
+
+bool writeJson(const std::string& path, const std::vector<Run>& runs, const Options& options)
+{
+    std::ofstream file(path);
+    if(!file)
+        return false;
+
+    file << "{\n  \"seed\": " << options.seed << ",\n  \"steps\": " << options.steps
+        << ",\n  \"warmup\": " << options.warmup << ",\n  \"dt\": " << options.dt
+        << ",\n  \"mode\": \"" << (options.worlds ? "worlds" : "jobs") << "\""
+        << ",\n  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n  \"runs\": [\n";
+    for(size_t i = 0; i < runs.size(); i++)
+    {
+        const auto& r = runs[i];
+        file << std::fixed << std::setprecision(4)
+            << "    { \"scenario\": \"" << r.scenario << "\", \"bodies\": " << r.bodies
+            << ", \"world_bodies\": " << r.worldBodies << ", \"threads\": " << r.threads
+            << ", \"mean_ms\": " << r.mean << ", \"p50_ms\": " << r.p50 << ", \"p90_ms\": " << r.p90
+            << ", \"p99_ms\": " << r.p99 << ", \"max_ms\": " << r.max
+            << ", \"steps_per_s\": " << std::setprecision(1) << r.stepsPerSecond
+            << ", \"scaling_exponent\": " << std::setprecision(3) << r.exponent
+            << ", \"rss_kb\": " << r.rssKb << ", \"peak_rss_kb\": " << r.peakRssKb
+            << " }" << (i + 1 < runs.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return static_cast<bool>(file);
+}